@@ -25,6 +25,8 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 
+#include "jw_shadow.h"
+
 struct buffer_object {
 	uint32_t width;
 	uint32_t height;
@@ -36,11 +38,26 @@ struct buffer_object {
 };
 
 struct buffer_object buf;
+static jw_shadow_t shadow; // drawing happens here, the dumb buffer is only written
 static int drm_fd;
 static uint32_t conn_id;
 static uint32_t crtc_id;
 static drmModeModeInfo mode;
 
+// Last working setup, so a cold start can skip probing every connector
+#define MODESET_CACHE_PATH "/var/tmp/jw_drm_test.cache" // survives reboots, JW_DRM_CACHE overrides
+#define MODESET_CACHE_MAGIC 0x4A57444Du // "JWDM"
+
+struct modeset_cache {
+	uint32_t magic;
+	uint32_t size;              // sizeof(struct modeset_cache), catches layout changes
+	uint32_t conn_id;
+	uint32_t conn_type;         // guards against ids being handed out differently
+	uint32_t conn_type_id;
+	uint32_t crtc_id;
+	drmModeModeInfo mode;
+};
+
 static int modeset_create_fb(int fd, struct buffer_object *bo)
 {
 	struct drm_mode_create_dumb create = {};
@@ -174,33 +191,184 @@ static int modeset_setup_dev(int fd, drmModeRes **res, drmModeConnector **conn,
 	return -ENOENT;
 }
 
+static const char *modeset_cache_path(void)
+{
+	const char *path = getenv("JW_DRM_CACHE");
+	return path && *path ? path : MODESET_CACHE_PATH;
+}
+
+static bool mode_equal(const drmModeModeInfo *a, const drmModeModeInfo *b)
+{
+	return a->clock == b->clock &&
+	       a->hdisplay == b->hdisplay && a->hsync_start == b->hsync_start &&
+	       a->hsync_end == b->hsync_end && a->htotal == b->htotal && a->hskew == b->hskew &&
+	       a->vdisplay == b->vdisplay && a->vsync_start == b->vsync_start &&
+	       a->vsync_end == b->vsync_end && a->vtotal == b->vtotal && a->vscan == b->vscan &&
+	       a->flags == b->flags;
+}
+
+static int modeset_cache_load(struct modeset_cache *c)
+{
+	FILE *f = fopen(modeset_cache_path(), "rb");
+	if (!f)
+		return -ENOENT;
+	size_t n = fread(c, 1, sizeof(*c), f);
+	fclose(f);
+	if (n != sizeof(*c) || c->magic != MODESET_CACHE_MAGIC || c->size != sizeof(*c))
+		return -EINVAL;
+	return 0;
+}
+
+static void modeset_cache_save(const drmModeConnector *conn, uint32_t crtc, const drmModeModeInfo *m)
+{
+	struct modeset_cache c = {
+		.magic = MODESET_CACHE_MAGIC,
+		.size = sizeof(c),
+		.conn_id = conn->connector_id,
+		.conn_type = conn->connector_type,
+		.conn_type_id = conn->connector_type_id,
+		.crtc_id = crtc,
+		.mode = *m,
+	};
+	char tmp[512];
+	snprintf(tmp, sizeof(tmp), "%s.tmp", modeset_cache_path());
+	FILE *f = fopen(tmp, "wb");
+	if (!f)
+		return;
+	bool ok = fwrite(&c, sizeof(c), 1, f) == 1;
+	ok = fclose(f) == 0 && ok;
+	// Atomic replace, a torn cache would only cost a probe but never use one
+	if (!ok || rename(tmp, modeset_cache_path()))
+		unlink(tmp);
+}
+
+/*
+ * Validate the cache against what the kernel already knows. GetConnectorCurrent
+ * returns the last probed state without new EDID reads; after a hotplug the
+ * kernel has reprobed, so a changed connection or mode list shows up here and
+ * sends us to the full probe.
+ */
+static int modeset_setup_cached(int fd, drmModeConnector **conn, uint32_t *crtc_out,
+				drmModeModeInfo *mode_out, bool *mode_current)
+{
+	struct modeset_cache c;
+	int ret = modeset_cache_load(&c);
+	if (ret)
+		return ret;
+
+	*conn = drmModeGetConnectorCurrent(fd, c.conn_id);
+	if (!*conn)
+		return -ENOENT;
+
+	drmModeConnector *cn = *conn;
+	bool valid = cn->connection == DRM_MODE_CONNECTED &&
+		     cn->connector_type == c.conn_type && cn->connector_type_id == c.conn_type_id;
+	bool listed = false;
+	for (int i = 0; valid && i < cn->count_modes; i++)
+		listed |= mode_equal(&cn->modes[i], &c.mode);
+
+	// The CRTC must still be reachable from one of the connector's encoders
+	bool reachable = false;
+	drmModeRes *res = valid && listed ? drmModeGetResources(fd) : NULL;
+	for (int i = 0; res && !reachable && i < cn->count_encoders; ++i) {
+		drmModeEncoder *enc = drmModeGetEncoder(fd, cn->encoders[i]);
+		if (!enc)
+			continue;
+		for (int j = 0; j < res->count_crtcs; ++j)
+			if (res->crtcs[j] == c.crtc_id && (enc->possible_crtcs & (1u << j)))
+				reachable = true;
+		drmModeFreeEncoder(enc);
+	}
+	drmModeFreeResources(res);
+
+	if (!reachable) {
+		drmModeFreeConnector(cn);
+		*conn = NULL;
+		return -ESTALE;
+	}
+
+	// Already scanning out this mode (boot splash, previous run): no modeset needed
+	bool routed = false;
+	drmModeEncoder *enc = cn->encoder_id ? drmModeGetEncoder(fd, cn->encoder_id) : NULL;
+	if (enc) {
+		routed = enc->crtc_id == c.crtc_id;
+		drmModeFreeEncoder(enc);
+	}
+	drmModeCrtc *cur = routed ? drmModeGetCrtc(fd, c.crtc_id) : NULL;
+	*mode_current = cur && cur->mode_valid && cur->buffer_id && mode_equal(&cur->mode, &c.mode);
+	drmModeFreeCrtc(cur);
+
+	*crtc_out = c.crtc_id;
+	*mode_out = c.mode;
+	return 0;
+}
+
+static void present(struct buffer_object *bo)
+{
+	drmModeClip clips[JW_SHADOW_MAX_DAMAGE];
+	int n = shadow.damage_count;
+	for (int i = 0; i < n; i++) {
+		jw_shadow_rect_t *r = &shadow.damage[i];
+		clips[i] = (drmModeClip){ r->x, r->y, r->x + r->w, r->y + r->h };
+	}
+
+	// The dumb buffer is usually write-combined: damaged lines only, streamed
+	jw_shadow_flush(&shadow);
+
+    // Important: For virtual drivers (virtio, vmwgfx, qxl) or USB diaplay links,
+    // we must manually flush the changed area using the DIRTYFB ioctl.
+    // Without this, the screen may remain black even if memory is written.
+	if (n)
+		drmModeDirtyFB(drm_fd, bo->fb_id, clips, n);
+}
+
 static void fill_buffer(struct buffer_object *bo, uint8_t r, uint8_t g, uint8_t b)
 {
 	// Assuming 32-bit (XRGB8888 or ARGB8888)
 	// Byte order is typically B G R A (little endian)
 	uint32_t color = (r << 16) | (g << 8) | b;
-	for (uint32_t i = 0; i < bo->size / 4; i++) {
-		((uint32_t*)bo->map)[i] = color;
+	for (uint32_t y = 0; y < bo->height; y++) {
+		uint32_t *row = (uint32_t*)jw_shadow_at(&shadow, 0, y);
+		for (uint32_t x = 0; x < bo->width; x++)
+			row[x] = color;
 	}
+	jw_shadow_damage(&shadow, 0, 0, bo->width, bo->height);
+	present(bo);
+}
 
-    // Important: For virtual drivers (virtio, vmwgfx, qxl) or USB diaplay links,
-    // we must manually flush the changed area using the DIRTYFB ioctl.
-    // Without this, the screen may remain black even if memory is written.
-    drmModeClip clip = {
-        .x1 = 0,
-        .y1 = 0,
-        .x2 = bo->width,
-        .y2 = bo->height,
-    };
-    drmModeDirtyFB(drm_fd, bo->fb_id, &clip, 1);
+// 50% white over the middle quarter: read-modify-write, cached memory only
+static void blend_box(struct buffer_object *bo)
+{
+	int x0 = bo->width / 4, y0 = bo->height / 4;
+	int w = bo->width / 2, h = bo->height / 2;
+	for (int y = y0; y < y0 + h; y++) {
+		uint32_t *row = (uint32_t*)jw_shadow_at(&shadow, x0, y);
+		for (int x = 0; x < w; x++)
+			row[x] = ((row[x] >> 1) & 0x7F7F7F) + 0x808080;
+	}
+	jw_shadow_damage(&shadow, x0, y0, w, h);
+	present(bo);
 }
 
 int main(int argc, char **argv)
 {
 	int ret;
-	drmModeRes *res;
-	drmModeConnector *conn;
+	drmModeRes *res = NULL;
+	drmModeConnector *conn = NULL;
 	uint32_t crtc;
+	bool use_cache = true;
+	bool mode_current = false;
+	struct timespec t0, t1;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--probe") == 0) {
+			use_cache = false;
+		} else {
+			fprintf(stderr, "usage: %s [--probe]\n", argv[0]);
+			return 1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t0);
 	
 	// Open DRM device
 	drm_fd = open("/dev/dri/card0", O_RDWR | O_CLOEXEC);
@@ -209,19 +377,24 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
-	// Setup DRM resources
-	ret = modeset_setup_dev(drm_fd, &res, &conn, &crtc);
-	if (ret) {
-		close(drm_fd);
-		return 1;
+	// Setup DRM resources, probing everything only when the cache does not hold
+	ret = use_cache ? modeset_setup_cached(drm_fd, &conn, &crtc, &mode, &mode_current) : -1;
+	bool cached = ret == 0;
+	if (!cached) {
+		ret = modeset_setup_dev(drm_fd, &res, &conn, &crtc);
+		if (ret) {
+			close(drm_fd);
+			return 1;
+		}
+		// Use the first valid mode
+		mode = conn->modes[0];
 	}
 
-	// Use the first valid mode
 	conn_id = conn->connector_id;
 	crtc_id = crtc;
-	mode = conn->modes[0];
 	
-	printf("Using mode: %s %dx%d\n", mode.name, mode.hdisplay, mode.vdisplay);
+	printf("Using mode: %s %dx%d (%s)\n", mode.name, mode.hdisplay, mode.vdisplay,
+	       cached ? "cached" : "probed");
 
 	// Create dumb buffer matching the mode
 	buf.width = mode.hdisplay;
@@ -231,13 +404,28 @@ int main(int argc, char **argv)
 		goto cleanup;
 	}
 
-	// Set mode!
-	ret = drmModeSetCrtc(drm_fd, crtc_id, buf.fb_id, 0, 0, &conn_id, 1, &mode);
+	ret = jw_shadow_init(&shadow, buf.map, buf.width, buf.height, 4, buf.stride);
 	if (ret) {
-		fprintf(stderr, "cannot set CRTC for connector %u (%d): %m\n", conn_id, errno);
+		fprintf(stderr, "cannot allocate shadow buffer\n");
 		goto cleanup_fb;
 	}
 
+	// Set mode! Unless the CRTC already runs it: then a flip swaps the buffer
+	// without the blank a full modeset can cause.
+	ret = mode_current ? drmModePageFlip(drm_fd, crtc_id, buf.fb_id, 0, NULL) : -1;
+	if (ret)
+		ret = drmModeSetCrtc(drm_fd, crtc_id, buf.fb_id, 0, 0, &conn_id, 1, &mode);
+	if (ret) {
+		fprintf(stderr, "cannot set CRTC for connector %u (%d): %m\n", conn_id, errno);
+		goto cleanup_shadow;
+	}
+	if (!cached)
+		modeset_cache_save(conn, crtc_id, &mode);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("Scanout ready in %.1f ms\n",
+	       (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+
 	// Step 1: Red
 	printf("Displaying RED...\n");
 	fill_buffer(&buf, 255, 0, 0);
@@ -252,9 +440,16 @@ int main(int argc, char **argv)
 	printf("Displaying BLUE...\n");
 	fill_buffer(&buf, 0, 0, 255);
 	sleep(3);
+
+	// Step 4: only the box is damaged and pushed
+	printf("Blending a box...\n");
+	blend_box(&buf);
+	sleep(3);
     
     printf("Test finished.\n");
 
+cleanup_shadow:
+	jw_shadow_destroy(&shadow);
 cleanup_fb:
 	modeset_destroy_fb(drm_fd, &buf);
 cleanup:
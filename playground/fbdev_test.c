@@ -22,10 +22,14 @@
 #include <stdint.h>
 #include <errno.h>
 
+#include "jw_shadow.h"
+
 /**
  * JingWei Experiment: fbdev yellow screen test
  * Draws 255, 255, 0 (Yellow) to the framebuffer /dev/fb0
  * Strictly C implementation as per architecture requirements.
+ * Pixels are drawn into a cached shadow and streamed out, /dev/fb0 is
+ * usually uncached and never read.
  */
 
 int main() {
@@ -59,6 +63,17 @@ int main() {
         return 1;
     }
 
+    // The shadow starts at the visible line, xoffset stays inside it
+    int bytes_pp = vinfo.bits_per_pixel / 8;
+    jw_shadow_t shadow;
+    if (jw_shadow_init(&shadow, fbp + vinfo.yoffset * finfo.line_length,
+                       vinfo.xoffset + vinfo.xres, vinfo.yres, bytes_pp, finfo.line_length)) {
+        fprintf(stderr, "Error: cannot allocate shadow buffer\n");
+        munmap(fbp, screensize);
+        close(fb_fd);
+        return 1;
+    }
+
     printf("Display info: %dx%d, %d bpp\n", vinfo.xres, vinfo.yres, vinfo.bits_per_pixel);
 
     // Drawing Yellow (255, 255, 0)
@@ -74,8 +89,7 @@ int main() {
 
     for (uint32_t y = 0; y < vinfo.yres; y++) {
         for (uint32_t x = 0; x < vinfo.xres; x++) {
-            long location = (x + vinfo.xoffset) * (vinfo.bits_per_pixel / 8) +
-                            (y + vinfo.yoffset) * finfo.line_length;
+            uint8_t* px = jw_shadow_at(&shadow, x + vinfo.xoffset, y);
 
             if (vinfo.bits_per_pixel == 32) {
                 // Assuming typical 32-bit layout: AARRGGBB or similar.
@@ -88,14 +102,14 @@ int main() {
                      pixel |= (255 << a_off);
                 }
                 
-                *((uint32_t*)(fbp + location)) = pixel;
+                *((uint32_t*)px) = pixel;
 
             } else if (vinfo.bits_per_pixel == 24) {
                  // Fallback to byte writing if offsets align to bytes
                  if (r_off % 8 == 0 && g_off % 8 == 0 && b_off % 8 == 0) {
-                     fbp[location + (r_off / 8)] = 255;
-                     fbp[location + (g_off / 8)] = 255;
-                     fbp[location + (b_off / 8)] = 0;
+                     px[r_off / 8] = 255;
+                     px[g_off / 8] = 255;
+                     px[b_off / 8] = 0;
                  }
             } else if (vinfo.bits_per_pixel == 16) {
                 // RGB565 usually: Red 5 bits, Green 6 bits, Blue 5 bits
@@ -109,13 +123,17 @@ int main() {
                 pixel |= (g << g_off);
                 pixel |= (b << b_off);
                 
-                *((uint16_t*)(fbp + location)) = pixel;
+                *((uint16_t*)px) = pixel;
             }
         }
     }
 
+    jw_shadow_damage(&shadow, vinfo.xoffset, 0, vinfo.xres, vinfo.yres);
+    jw_shadow_flush(&shadow);
+
     printf("Screen painted yellow!\n");
 
+    jw_shadow_destroy(&shadow);
     munmap(fbp, screensize);
     close(fb_fd);
     return 0;
@@ -0,0 +1,150 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_shadow.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_SHADOW_H
+#define JW_SHADOW_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Cached shadow of a scanout buffer (/dev/fb0, a DRM dumb buffer).
+ *
+ * Scanout memory is mapped uncached or write-combined: every read stalls on
+ * the bus, so anything that blends or otherwise reads pixels must do it here.
+ * The shadow has the scanout's stride, so a byte has the same offset within
+ * its cache line in both. Drawing marks damage; jw_shadow_flush() then writes
+ * the damaged spans, widened to whole 64-byte lines, with non-temporal stores
+ * and never reads the scanout back.
+ */
+
+#define JW_SHADOW_LINE 64
+#define JW_SHADOW_MAX_DAMAGE 16 // more rects collapse into their bounds
+
+typedef struct jw_shadow_rect {
+    int x, y, w, h;
+} jw_shadow_rect_t;
+
+typedef struct jw_shadow {
+    uint8_t *pixels;        // cached, JW_SHADOW_LINE aligned
+    uint8_t *scanout;       // first visible pixel
+    int width, height;
+    int bpp;                // bytes per pixel
+    int stride;             // both buffers
+    jw_shadow_rect_t damage[JW_SHADOW_MAX_DAMAGE];
+    int damage_count;
+} jw_shadow_t;
+
+static inline int jw_shadow_init(jw_shadow_t *sh, uint8_t *scanout, int width, int height, int bpp, int stride) {
+    memset(sh, 0, sizeof(*sh));
+    size_t size = ((size_t)stride * height + JW_SHADOW_LINE - 1) / JW_SHADOW_LINE * JW_SHADOW_LINE;
+    void *p = NULL;
+    if (posix_memalign(&p, JW_SHADOW_LINE, size) != 0) return -1;
+    memset(p, 0, size);
+    sh->pixels = (uint8_t*)p;
+    sh->scanout = scanout;
+    sh->width = width;
+    sh->height = height;
+    sh->bpp = bpp;
+    sh->stride = stride;
+    return 0;
+}
+
+static inline void jw_shadow_destroy(jw_shadow_t *sh) {
+    free(sh->pixels);
+    sh->pixels = NULL;
+}
+
+static inline uint8_t *jw_shadow_at(jw_shadow_t *sh, int x, int y) {
+    return sh->pixels + (size_t)y * sh->stride + (size_t)x * sh->bpp;
+}
+
+static inline void jw_shadow_damage(jw_shadow_t *sh, int x, int y, int w, int h) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > sh->width) w = sh->width - x;
+    if (y + h > sh->height) h = sh->height - y;
+    if (w <= 0 || h <= 0) return;
+
+    if (sh->damage_count == JW_SHADOW_MAX_DAMAGE) {
+        jw_shadow_rect_t *b = &sh->damage[0];
+        for (int i = 1; i < sh->damage_count; i++) {
+            jw_shadow_rect_t *r = &sh->damage[i];
+            int x2 = b->x + b->w > r->x + r->w ? b->x + b->w : r->x + r->w;
+            int y2 = b->y + b->h > r->y + r->h ? b->y + b->h : r->y + r->h;
+            if (r->x < b->x) b->x = r->x;
+            if (r->y < b->y) b->y = r->y;
+            b->w = x2 - b->x;
+            b->h = y2 - b->y;
+        }
+        sh->damage_count = 1;
+    }
+    sh->damage[sh->damage_count++] = (jw_shadow_rect_t){ x, y, w, h };
+}
+
+// Copy n bytes to write-combined memory, 16-byte stores once dst is aligned
+static inline void jw_shadow_stream(uint8_t *dst, const uint8_t *src, size_t n) {
+#if defined(__SSE2__)
+    while (n && ((uintptr_t)dst & 15)) { *dst++ = *src++; n--; }
+    for (; n >= 16; n -= 16, dst += 16, src += 16)
+        _mm_stream_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+#elif defined(__aarch64__)
+    while (n && ((uintptr_t)dst & 15)) { *dst++ = *src++; n--; }
+    for (; n >= 16; n -= 16, dst += 16, src += 16) {
+        uint64_t a, b;
+        memcpy(&a, src, 8);
+        memcpy(&b, src + 8, 8);
+        __asm__ volatile("stnp %0, %1, [%2]" :: "r"(a), "r"(b), "r"(dst) : "memory");
+    }
+#endif
+    memcpy(dst, src, n);
+}
+
+// Push the damage to scanout and clear it
+static inline void jw_shadow_flush(jw_shadow_t *sh) {
+    for (int i = 0; i < sh->damage_count; i++) {
+        jw_shadow_rect_t *r = &sh->damage[i];
+        for (int y = r->y; y < r->y + r->h; y++) {
+            size_t row = (size_t)y * sh->stride;
+            size_t from = row + (size_t)r->x * sh->bpp;
+            size_t to = row + (size_t)(r->x + r->w) * sh->bpp;
+            // Whole lines: partial ones would leave the WC buffer half full
+            from = from / JW_SHADOW_LINE * JW_SHADOW_LINE;
+            to = (to + JW_SHADOW_LINE - 1) / JW_SHADOW_LINE * JW_SHADOW_LINE;
+            if (from < row) from = row;
+            if (to > row + (size_t)sh->stride) to = row + (size_t)sh->stride;
+            jw_shadow_stream(sh->scanout + from, sh->pixels + from, to - from);
+        }
+    }
+#if defined(__SSE2__)
+    _mm_sfence();
+#else
+    __sync_synchronize();
+#endif
+    sh->damage_count = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_SHADOW_H
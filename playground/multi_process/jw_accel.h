@@ -0,0 +1,207 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_accel.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_ACCEL_H
+#define JW_MT_ACCEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct jw_rect {
+    int x, y, w, h;
+} jw_rect_t;
+
+// Pixel formats, values match JW_PIXFMT_* on the wire
+typedef enum {
+    JW_FORMAT_ARGB8888 = 0, // straight alpha
+    JW_FORMAT_XRGB8888,     // alpha byte ignored, always opaque
+    JW_FORMAT_RGB565,
+    JW_FORMAT_ARGB4444,
+    JW_FORMAT_A8,           // coverage only, for masks and glyphs
+    JW_FORMAT_COUNT
+} jw_format_t;
+
+// Pixel buffer
+typedef struct jw_buffer {
+    int w, h;
+    int stride;         // bytes per row
+    void *pixels;
+    jw_format_t format;
+} jw_buffer_t;
+
+static inline int jw_format_bpp(jw_format_t format) {
+    switch (format) {
+        case JW_FORMAT_RGB565:
+        case JW_FORMAT_ARGB4444: return 2;
+        case JW_FORMAT_A8:       return 1;
+        default:                 return 4;
+    }
+}
+
+static inline bool jw_format_opaque(jw_format_t format) {
+    return format == JW_FORMAT_XRGB8888 || format == JW_FORMAT_RGB565;
+}
+
+typedef enum {
+    JW_BLEND_NONE = 0,  // plain copy
+    JW_BLEND_SRC_OVER   // Porter-Duff source over
+} jw_blend_mode_t;
+
+typedef enum {
+    JW_FILTER_NEAREST = 0,
+    JW_FILTER_BILINEAR
+} jw_filter_t;
+
+// Clockwise rotation of the output
+typedef enum {
+    JW_ROTATE_0 = 0,
+    JW_ROTATE_90,
+    JW_ROTATE_180,
+    JW_ROTATE_270
+} jw_rotation_t;
+
+// Linear gradient, interpolated across `extent` (not the clipped target rect)
+typedef struct jw_gradient {
+    jw_rect_t extent;
+    uint32_t from, to;  // ARGB8888
+    bool vertical;      // true: top->bottom, false: left->right
+    uint8_t alpha;      // global alpha, 255 = opaque
+} jw_gradient_t;
+
+typedef struct jw_accelerator jw_accelerator_t;
+
+// Completion point in an accelerator's queue, see ops->fence
+typedef struct jw_fence jw_fence_t;
+
+// Accelerator ops. All rects are expected to be clipped to the buffers already.
+// Colours are ARGB8888, buffers may be in any jw_format_t (A8 only as a source).
+//
+// Drawing ops may only queue the work and return. They run in submission order
+// as far as anyone can tell, but buffer memory must stay valid (and sources
+// unchanged) until a fence taken after them has signalled, or sync returned.
+struct jw_accelerator_ops {
+    // 基础 2D 操作
+    int (*fill_rect)(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, uint32_t color);
+    int (*blend_rect)(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, uint32_t color, uint8_t alpha);
+    int (*gradient)(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, const jw_gradient_t *grad);
+
+    // 拷贝与合成 (src_rect size is used, dst_rect only gives the position)
+    int (*blit)(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                jw_buffer_t *dst, const jw_rect_t *dst_rect);
+    int (*blend)(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                 jw_buffer_t *dst, const jw_rect_t *dst_rect, jw_blend_mode_t mode, uint8_t alpha);
+
+    // A8 coverage from `mask` tints `color` onto dst (glyphs, icons)
+    int (*blend_mask)(jw_accelerator_t *acc, const jw_buffer_t *mask, const jw_rect_t *src_rect,
+                      jw_buffer_t *dst, const jw_rect_t *dst_rect, uint32_t color, uint8_t alpha);
+
+    // 缩放: map src_rect onto dst_rect, writing only the part inside clip
+    int (*scale)(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                 jw_buffer_t *dst, const jw_rect_t *dst_rect, const jw_rect_t *clip,
+                 jw_filter_t filter, jw_blend_mode_t mode, uint8_t alpha);
+
+    // 旋转: copy src_rect into dst, which is src rotated by `rot` as a whole
+    int (*rotate)(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                  jw_buffer_t *dst, jw_rotation_t rot);
+
+    // 硬件特定的同步操作
+    int (*sync)(jw_accelerator_t *acc);
+
+    // 栅栏: signals once every op queued before it is done
+    jw_fence_t *(*fence)(jw_accelerator_t *acc);
+    // 0 once signalled, 1 on timeout (0 ms just polls, -1 waits forever), -1 on error
+    int (*fence_wait)(jw_accelerator_t *acc, jw_fence_t *fence, int timeout_ms);
+    // Pollable fd, readable once signalled. Owned by the fence.
+    int (*fence_fd)(jw_accelerator_t *acc, jw_fence_t *fence);
+    void (*fence_release)(jw_accelerator_t *acc, jw_fence_t *fence);
+};
+
+struct jw_accelerator {
+    const struct jw_accelerator_ops *ops;
+    const char *name;
+};
+
+// Pure CPU implementation, always available. Ops run on a worker pool that
+// splits them into row bands, JW_SOFT_THREADS=n overrides the pool size
+// (0 runs everything inline on the caller).
+jw_accelerator_t *jw_accel_soft_create(void);
+void jw_accel_soft_destroy(jw_accelerator_t *acc);
+
+// Rect helpers
+static inline bool jw_rect_empty(const jw_rect_t *r) {
+    return r->w <= 0 || r->h <= 0;
+}
+
+static inline bool jw_rect_intersect(const jw_rect_t *a, const jw_rect_t *b, jw_rect_t *out) {
+    int x1 = a->x > b->x ? a->x : b->x;
+    int y1 = a->y > b->y ? a->y : b->y;
+    int x2 = (a->x + a->w) < (b->x + b->w) ? (a->x + a->w) : (b->x + b->w);
+    int y2 = (a->y + a->h) < (b->y + b->h) ? (a->y + a->h) : (b->y + b->h);
+    out->x = x1;
+    out->y = y1;
+    out->w = x2 - x1;
+    out->h = y2 - y1;
+    return !jw_rect_empty(out);
+}
+
+// Bounding box of a and b, empty rects are ignored
+static inline void jw_rect_union(jw_rect_t *acc, const jw_rect_t *r) {
+    if (jw_rect_empty(r)) return;
+    if (jw_rect_empty(acc)) {
+        *acc = *r;
+        return;
+    }
+    int x1 = acc->x < r->x ? acc->x : r->x;
+    int y1 = acc->y < r->y ? acc->y : r->y;
+    int x2 = (acc->x + acc->w) > (r->x + r->w) ? (acc->x + acc->w) : (r->x + r->w);
+    int y2 = (acc->y + acc->h) > (r->y + r->h) ? (acc->y + acc->h) : (r->y + r->h);
+    acc->x = x1;
+    acc->y = y1;
+    acc->w = x2 - x1;
+    acc->h = y2 - y1;
+}
+
+// Where `r` of a w x h buffer lands after rotating the buffer by `rot`
+static inline jw_rect_t jw_rect_rotate(const jw_rect_t *r, int w, int h, jw_rotation_t rot) {
+    jw_rect_t out = *r;
+    switch (rot) {
+        case JW_ROTATE_90:  out.x = h - r->y - r->h; out.y = r->x; out.w = r->h; out.h = r->w; break;
+        case JW_ROTATE_180: out.x = w - r->x - r->w; out.y = h - r->y - r->h; break;
+        case JW_ROTATE_270: out.x = r->y; out.y = w - r->x - r->w; out.w = r->h; out.h = r->w; break;
+        default: break;
+    }
+    return out;
+}
+
+static inline uint8_t *jw_buffer_line(const jw_buffer_t *buf, int y) {
+    return (uint8_t*)buf->pixels + (long)y * buf->stride;
+}
+
+static inline uint8_t *jw_buffer_at(const jw_buffer_t *buf, int x, int y) {
+    return jw_buffer_line(buf, y) + x * jw_format_bpp(buf->format);
+}
+
+// 32-bit formats only
+static inline uint32_t *jw_buffer_row(const jw_buffer_t *buf, int y) {
+    return (uint32_t*)jw_buffer_line(buf, y);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_ACCEL_H
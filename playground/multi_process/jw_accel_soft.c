@@ -0,0 +1,954 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_accel_soft.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#include "jw_accel.h"
+
+// Per-pixel helpers must fold into the specialised kernels below
+#define JW_SOFT_INLINE __attribute__((always_inline))
+
+/**
+ * Soft accelerator: plain CPU implementation of jw_accelerator_ops.
+ * Blending happens on straight-alpha ARGB8888 values; other formats are
+ * converted on load/store, with direct paths for ARGB8888 and same-format copies.
+ */
+
+// (x * a) / 255 with rounding, exact for 8-bit inputs
+static inline uint32_t mul255(uint32_t x, uint32_t a) {
+    uint32_t t = x * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// Source-over for one straight-alpha pixel, `a` is the effective source alpha
+static inline uint32_t blend_pixel(uint32_t s, uint32_t d, uint32_t a) {
+    if (a == 255) return s | 0xFF000000u;
+    if (a == 0) return d;
+
+    uint32_t ia = 255 - a;
+    uint32_t da = d >> 24;
+    uint32_t oa = a + mul255(da, ia);
+
+    uint32_t r = mul255((s >> 16) & 0xFF, a) + mul255((d >> 16) & 0xFF, ia);
+    uint32_t g = mul255((s >> 8) & 0xFF, a) + mul255((d >> 8) & 0xFF, ia);
+    uint32_t b = mul255(s & 0xFF, a) + mul255(d & 0xFF, ia);
+
+    return (oa << 24) | (r << 16) | (g << 8) | b;
+}
+
+static inline uint32_t lerp_color(uint32_t from, uint32_t to, uint32_t t /* 0..256 */) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int c0 = (from >> shift) & 0xFF;
+        int c1 = (to >> shift) & 0xFF;
+        out |= (uint32_t)((c0 + (((c1 - c0) * (int)t) >> 8)) & 0xFF) << shift;
+    }
+    return out;
+}
+
+// Any format -> ARGB8888
+static inline JW_SOFT_INLINE uint32_t load_pixel(const uint8_t *p, jw_format_t format) {
+    switch (format) {
+        case JW_FORMAT_ARGB8888:
+            return *(const uint32_t*)p;
+        case JW_FORMAT_XRGB8888:
+            return *(const uint32_t*)p | 0xFF000000u;
+        case JW_FORMAT_RGB565: {
+            uint32_t v = *(const uint16_t*)p;
+            uint32_t r = (v >> 11) & 0x1F, g = (v >> 5) & 0x3F, b = v & 0x1F;
+            return 0xFF000000u | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+        }
+        case JW_FORMAT_ARGB4444: {
+            uint32_t v = *(const uint16_t*)p;
+            return (((v >> 12) & 0xF) * 0x11u) << 24 | (((v >> 8) & 0xF) * 0x11u) << 16 |
+                   (((v >> 4) & 0xF) * 0x11u) << 8 | ((v & 0xF) * 0x11u);
+        }
+        case JW_FORMAT_A8:
+            return (uint32_t)*p << 24;
+        default:
+            return 0;
+    }
+}
+
+// ARGB8888 -> any format
+static inline JW_SOFT_INLINE void store_pixel(uint8_t *p, jw_format_t format, uint32_t c) {
+    switch (format) {
+        case JW_FORMAT_ARGB8888:
+            *(uint32_t*)p = c;
+            break;
+        case JW_FORMAT_XRGB8888:
+            *(uint32_t*)p = c | 0xFF000000u;
+            break;
+        case JW_FORMAT_RGB565:
+            *(uint16_t*)p = (uint16_t)(((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F));
+            break;
+        case JW_FORMAT_ARGB4444:
+            *(uint16_t*)p = (uint16_t)(((c >> 16) & 0xF000) | ((c >> 12) & 0x0F00) | ((c >> 8) & 0x00F0) | ((c >> 4) & 0x000F));
+            break;
+        case JW_FORMAT_A8:
+            *p = (uint8_t)(c >> 24);
+            break;
+        default:
+            break;
+    }
+}
+
+static int soft_fill_rect(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, uint32_t color) {
+    (void)acc;
+    int bpp = jw_format_bpp(dst->format);
+    uint8_t packed[4];
+    store_pixel(packed, dst->format, color);
+
+    for (int y = 0; y < rect->h; y++) {
+        uint8_t *line = jw_buffer_at(dst, rect->x, rect->y + y);
+        if (bpp == 4) {
+            uint32_t v, *row = (uint32_t*)line;
+            memcpy(&v, packed, 4);
+            for (int x = 0; x < rect->w; x++) row[x] = v;
+        } else if (bpp == 2) {
+            uint16_t v, *row = (uint16_t*)line;
+            memcpy(&v, packed, 2);
+            for (int x = 0; x < rect->w; x++) row[x] = v;
+        } else {
+            memset(line, packed[0], rect->w);
+        }
+    }
+    return 0;
+}
+
+static int soft_blend_rect(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, uint32_t color, uint8_t alpha) {
+    uint32_t a = mul255(color >> 24, alpha);
+    if (a == 255) return soft_fill_rect(acc, dst, rect, color);
+    if (a == 0) return 0;
+
+    int bpp = jw_format_bpp(dst->format);
+    for (int y = 0; y < rect->h; y++) {
+        if (dst->format == JW_FORMAT_ARGB8888) {
+            uint32_t *row = jw_buffer_row(dst, rect->y + y) + rect->x;
+            for (int x = 0; x < rect->w; x++) {
+                row[x] = blend_pixel(color, row[x], a);
+            }
+        } else {
+            uint8_t *p = jw_buffer_at(dst, rect->x, rect->y + y);
+            for (int x = 0; x < rect->w; x++, p += bpp) {
+                store_pixel(p, dst->format, blend_pixel(color, load_pixel(p, dst->format), a));
+            }
+        }
+    }
+    return 0;
+}
+
+static int soft_gradient(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, const jw_gradient_t *grad) {
+    int span = grad->vertical ? grad->extent.h : grad->extent.w;
+    if (span <= 0) return -1;
+    int denom = span > 1 ? span - 1 : 1;
+    int bpp = jw_format_bpp(dst->format);
+
+    // Opaque gradients are written, anything else is blended per pixel
+    bool opaque = grad->alpha == 255 && (grad->from >> 24) == 255 && (grad->to >> 24) == 255;
+
+    if (grad->vertical) {
+        // One colour per row
+        for (int y = 0; y < rect->h; y++) {
+            uint32_t t = (uint32_t)(((rect->y + y - grad->extent.y) * 256) / denom);
+            uint32_t color = lerp_color(grad->from, grad->to, t);
+            jw_rect_t row = { rect->x, rect->y + y, rect->w, 1 };
+            if (opaque) {
+                soft_fill_rect(acc, dst, &row, color);
+            } else {
+                soft_blend_rect(acc, dst, &row, color, grad->alpha);
+            }
+        }
+    } else if (opaque) {
+        // Compute the first row, replicate it
+        uint8_t *first = jw_buffer_at(dst, rect->x, rect->y);
+        for (int x = 0; x < rect->w; x++) {
+            uint32_t t = (uint32_t)(((rect->x + x - grad->extent.x) * 256) / denom);
+            store_pixel(first + x * bpp, dst->format, lerp_color(grad->from, grad->to, t));
+        }
+        for (int y = 1; y < rect->h; y++) {
+            memcpy(jw_buffer_at(dst, rect->x, rect->y + y), first, (size_t)rect->w * bpp);
+        }
+    } else {
+        for (int y = 0; y < rect->h; y++) {
+            uint8_t *p = jw_buffer_at(dst, rect->x, rect->y + y);
+            for (int x = 0; x < rect->w; x++, p += bpp) {
+                uint32_t t = (uint32_t)(((rect->x + x - grad->extent.x) * 256) / denom);
+                uint32_t color = lerp_color(grad->from, grad->to, t);
+                store_pixel(p, dst->format, blend_pixel(color, load_pixel(p, dst->format), mul255(color >> 24, grad->alpha)));
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Span kernels specialised per (src format, dst format, blend): format and
+ * mode are compile-time constants in each, so load/store/blend fold into
+ * straight-line code without per-pixel switches. Ops pick one per call and
+ * fall back to the generic loops for anything not in the table (A8 sources,
+ * or formats stripped with the JW_SOFT_KERNELS_* build options).
+ */
+
+#ifndef JW_SOFT_KERNELS_XRGB8888
+#define JW_SOFT_KERNELS_XRGB8888 1
+#endif
+#ifndef JW_SOFT_KERNELS_RGB565
+#define JW_SOFT_KERNELS_RGB565 1
+#endif
+#ifndef JW_SOFT_KERNELS_ARGB4444
+#define JW_SOFT_KERNELS_ARGB4444 1
+#endif
+#ifndef JW_SOFT_KERNELS_GLOBAL_ALPHA
+#define JW_SOFT_KERNELS_GLOBAL_ALPHA 1
+#endif
+
+#if JW_SOFT_KERNELS_XRGB8888
+#define JW_SOFT_IF_XRGB8888(x) x
+#else
+#define JW_SOFT_IF_XRGB8888(x)
+#endif
+#if JW_SOFT_KERNELS_RGB565
+#define JW_SOFT_IF_RGB565(x) x
+#else
+#define JW_SOFT_IF_RGB565(x)
+#endif
+#if JW_SOFT_KERNELS_ARGB4444
+#define JW_SOFT_IF_ARGB4444(x) x
+#else
+#define JW_SOFT_IF_ARGB4444(x)
+#endif
+
+// Two lists because a macro cannot expand inside itself
+#define JW_SOFT_SRC_FORMATS(X, DF)                  \
+    X(ARGB8888, DF)                                 \
+    JW_SOFT_IF_XRGB8888(X(XRGB8888, DF))            \
+    JW_SOFT_IF_RGB565(X(RGB565, DF))                \
+    JW_SOFT_IF_ARGB4444(X(ARGB4444, DF))
+
+#define JW_SOFT_DST_FORMATS(X)                      \
+    X(ARGB8888)                                     \
+    JW_SOFT_IF_XRGB8888(X(XRGB8888))                \
+    JW_SOFT_IF_RGB565(X(RGB565))                    \
+    JW_SOFT_IF_ARGB4444(X(ARGB4444))
+
+typedef void (*soft_span_fn)(const uint8_t *s, uint8_t *d, int w, uint8_t alpha);
+
+enum {
+    SPAN_COPY = 0,      // JW_BLEND_NONE, converting
+    SPAN_OVER,          // source over, global alpha 255
+    SPAN_OVER_ALPHA,    // source over with global alpha
+    SPAN_KINDS
+};
+
+// Global alpha is folded away when it is a constant 255
+#define JW_SOFT_SPAN_OVER(NAME, SF, DF, ALPHA)                                              \
+    static void NAME##_##SF##_##DF(const uint8_t *s, uint8_t *d, int w, uint8_t alpha) {    \
+        const int sb = jw_format_bpp(JW_FORMAT_##SF), db = jw_format_bpp(JW_FORMAT_##DF);  \
+        (void)alpha;                                                                        \
+        for (int x = 0; x < w; x++, s += sb, d += db) {                                     \
+            uint32_t px = load_pixel(s, JW_FORMAT_##SF);                                    \
+            uint32_t a = (ALPHA) == 255 ? px >> 24 : mul255(px >> 24, (ALPHA));             \
+            store_pixel(d, JW_FORMAT_##DF, blend_pixel(px, load_pixel(d, JW_FORMAT_##DF), a)); \
+        }                                                                                   \
+    }
+
+#define JW_SOFT_SPAN_KERNELS(SF, DF)                                                        \
+    static void span_copy_##SF##_##DF(const uint8_t *s, uint8_t *d, int w, uint8_t alpha) { \
+        const int sb = jw_format_bpp(JW_FORMAT_##SF), db = jw_format_bpp(JW_FORMAT_##DF);  \
+        (void)alpha;                                                                        \
+        for (int x = 0; x < w; x++, s += sb, d += db) {                                     \
+            store_pixel(d, JW_FORMAT_##DF, load_pixel(s, JW_FORMAT_##SF));                  \
+        }                                                                                   \
+    }                                                                                       \
+    JW_SOFT_SPAN_OVER(span_over, SF, DF, 255)                                               \
+    JW_SOFT_SPAN_OVER_ALPHA_KERNEL(SF, DF)
+
+#if JW_SOFT_KERNELS_GLOBAL_ALPHA
+#define JW_SOFT_SPAN_OVER_ALPHA_KERNEL(SF, DF) JW_SOFT_SPAN_OVER(span_over_alpha, SF, DF, alpha)
+#define JW_SOFT_SPAN_OVER_ALPHA(SF, DF) span_over_alpha_##SF##_##DF
+#else
+#define JW_SOFT_SPAN_OVER_ALPHA_KERNEL(SF, DF)
+#define JW_SOFT_SPAN_OVER_ALPHA(SF, DF) NULL
+#endif
+
+#define JW_SOFT_SPAN_KERNELS_TO(DF) JW_SOFT_SRC_FORMATS(JW_SOFT_SPAN_KERNELS, DF)
+JW_SOFT_DST_FORMATS(JW_SOFT_SPAN_KERNELS_TO)
+
+#define JW_SOFT_SPAN_ENTRY(SF, DF)                                      \
+    [JW_FORMAT_##SF][JW_FORMAT_##DF] = {                                \
+        span_copy_##SF##_##DF,                                          \
+        span_over_##SF##_##DF,                                          \
+        JW_SOFT_SPAN_OVER_ALPHA(SF, DF)                                 \
+    },
+#define JW_SOFT_SPAN_ENTRIES_TO(DF) JW_SOFT_SRC_FORMATS(JW_SOFT_SPAN_ENTRY, DF)
+
+static const soft_span_fn span_table[JW_FORMAT_COUNT][JW_FORMAT_COUNT][SPAN_KINDS] = {
+    JW_SOFT_DST_FORMATS(JW_SOFT_SPAN_ENTRIES_TO)
+};
+
+// NULL when the combination has no specialised kernel
+static soft_span_fn span_kernel(jw_format_t src, jw_format_t dst, int kind) {
+    if (src >= JW_FORMAT_COUNT || dst >= JW_FORMAT_COUNT) return NULL;
+    return span_table[src][dst][kind];
+}
+
+static int soft_blit(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                     jw_buffer_t *dst, const jw_rect_t *dst_rect) {
+    (void)acc;
+    int sbpp = jw_format_bpp(src->format);
+    int dbpp = jw_format_bpp(dst->format);
+    soft_span_fn span = src->format == dst->format ? NULL : span_kernel(src->format, dst->format, SPAN_COPY);
+
+    for (int y = 0; y < src_rect->h; y++) {
+        const uint8_t *s = jw_buffer_at(src, src_rect->x, src_rect->y + y);
+        uint8_t *d = jw_buffer_at(dst, dst_rect->x, dst_rect->y + y);
+        if (src->format == dst->format) {
+            memcpy(d, s, (size_t)src_rect->w * sbpp);
+        } else if (span) {
+            span(s, d, src_rect->w, 255);
+        } else {
+            for (int x = 0; x < src_rect->w; x++, s += sbpp, d += dbpp) {
+                store_pixel(d, dst->format, load_pixel(s, src->format));
+            }
+        }
+    }
+    return 0;
+}
+
+static int soft_blend(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                      jw_buffer_t *dst, const jw_rect_t *dst_rect, jw_blend_mode_t mode, uint8_t alpha) {
+    if (mode == JW_BLEND_NONE || (jw_format_opaque(src->format) && alpha == 255)) {
+        return soft_blit(acc, src, src_rect, dst, dst_rect);
+    }
+
+    int sbpp = jw_format_bpp(src->format);
+    int dbpp = jw_format_bpp(dst->format);
+    soft_span_fn span = span_kernel(src->format, dst->format, alpha == 255 ? SPAN_OVER : SPAN_OVER_ALPHA);
+
+    for (int y = 0; y < src_rect->h; y++) {
+        const uint8_t *s = jw_buffer_at(src, src_rect->x, src_rect->y + y);
+        uint8_t *d = jw_buffer_at(dst, dst_rect->x, dst_rect->y + y);
+        if (span) {
+            span(s, d, src_rect->w, alpha);
+        } else {
+            for (int x = 0; x < src_rect->w; x++, s += sbpp, d += dbpp) {
+                uint32_t px = load_pixel(s, src->format);
+                store_pixel(d, dst->format, blend_pixel(px, load_pixel(d, dst->format), mul255(px >> 24, alpha)));
+            }
+        }
+    }
+    return 0;
+}
+
+static int soft_blend_mask(jw_accelerator_t *acc, const jw_buffer_t *mask, const jw_rect_t *src_rect,
+                           jw_buffer_t *dst, const jw_rect_t *dst_rect, uint32_t color, uint8_t alpha) {
+    (void)acc;
+    if (mask->format != JW_FORMAT_A8) return -1;
+
+    uint32_t ca = mul255(color >> 24, alpha);
+    int dbpp = jw_format_bpp(dst->format);
+    for (int y = 0; y < src_rect->h; y++) {
+        const uint8_t *m = jw_buffer_at(mask, src_rect->x, src_rect->y + y);
+        uint8_t *d = jw_buffer_at(dst, dst_rect->x, dst_rect->y + y);
+        for (int x = 0; x < src_rect->w; x++, d += dbpp) {
+            if (m[x] == 0) continue;
+            uint32_t a = mul255(m[x], ca);
+            store_pixel(d, dst->format, blend_pixel(color, load_pixel(d, dst->format), a));
+        }
+    }
+    return 0;
+}
+
+// Interpolate two pixels, w in 0..256. Two channels per multiply (0x00FF00FF
+// lanes), so the bilinear kernel does 6 multiplies per pixel instead of 16.
+static inline uint32_t lerp_swar(uint32_t a, uint32_t b, uint32_t w) {
+    uint32_t iw = 256 - w;
+    uint32_t rb = (((a & 0x00FF00FFu) * iw + (b & 0x00FF00FFu) * w) >> 8) & 0x00FF00FFu;
+    uint32_t ag = (((a >> 8) & 0x00FF00FFu) * iw + ((b >> 8) & 0x00FF00FFu) * w) & 0xFF00FF00u;
+    return rb | ag;
+}
+
+static inline void put_pixel(uint8_t *d, jw_format_t format, uint32_t px, jw_blend_mode_t mode, uint8_t alpha) {
+    if (mode == JW_BLEND_NONE) {
+        store_pixel(d, format, px);
+    } else {
+        uint32_t a = alpha == 255 ? px >> 24 : mul255(px >> 24, alpha);
+        store_pixel(d, format, blend_pixel(px, load_pixel(d, format), a));
+    }
+}
+
+// Columns per pass, wider spans are done in several
+#define JW_SCALE_MAX_SPAN 4096
+
+// One pass over c, at most JW_SCALE_MAX_SPAN wide. Positions are 16.16 in 64
+// bits, sources past 32767 pixels would overflow 32.
+static void scale_span(const jw_buffer_t *src, const jw_rect_t *src_rect, jw_buffer_t *dst,
+                       const jw_rect_t *dst_rect, jw_rect_t c, jw_filter_t filter,
+                       jw_blend_mode_t mode, uint8_t alpha) {
+    int sbpp = jw_format_bpp(src->format);
+    int dbpp = jw_format_bpp(dst->format);
+
+    // 16.16 source step per destination pixel
+    int64_t step_x = ((int64_t)src_rect->w << 16) / dst_rect->w;
+    int64_t step_y = ((int64_t)src_rect->h << 16) / dst_rect->h;
+
+    // Horizontal sample positions are the same for every row, compute them once
+    int32_t xs[JW_SCALE_MAX_SPAN];
+    uint8_t wx[JW_SCALE_MAX_SPAN];
+    int max_x = src_rect->w - 1;
+
+    if (filter == JW_FILTER_NEAREST) {
+        for (int x = 0; x < c.w; x++) {
+            int64_t sx = ((int64_t)(c.x - dst_rect->x + x) * step_x + step_x / 2) >> 16;
+            xs[x] = src_rect->x + (int)(sx > max_x ? max_x : sx);
+        }
+        for (int y = 0; y < c.h; y++) {
+            int sy = (int)(((int64_t)(c.y - dst_rect->y + y) * step_y + step_y / 2) >> 16);
+            if (sy >= src_rect->h) sy = src_rect->h - 1;
+            const uint8_t *s = jw_buffer_line(src, src_rect->y + sy);
+            uint8_t *d = jw_buffer_at(dst, c.x, c.y + y);
+            if (mode == JW_BLEND_NONE && src->format == JW_FORMAT_ARGB8888 && dst->format == JW_FORMAT_ARGB8888) {
+                for (int x = 0; x < c.w; x++) ((uint32_t*)d)[x] = ((const uint32_t*)s)[xs[x]];
+            } else {
+                for (int x = 0; x < c.w; x++, d += dbpp) {
+                    put_pixel(d, dst->format, load_pixel(s + xs[x] * sbpp, src->format), mode, alpha);
+                }
+            }
+        }
+        return;
+    }
+
+    // Bilinear, sampling at pixel centres and clamping at the edges
+    for (int x = 0; x < c.w; x++) {
+        int64_t fx = (int64_t)(c.x - dst_rect->x + x) * step_x + step_x / 2 - 0x8000;
+        if (fx < 0) fx = 0;
+        if (fx > ((int64_t)max_x << 16)) fx = (int64_t)max_x << 16;
+        xs[x] = (int32_t)(fx >> 16);
+        wx[x] = (fx >> 8) & 0xFF;
+    }
+    for (int y = 0; y < c.h; y++) {
+        int64_t fy = (int64_t)(c.y - dst_rect->y + y) * step_y + step_y / 2 - 0x8000;
+        if (fy < 0) fy = 0;
+        if (fy > ((int64_t)(src_rect->h - 1) << 16)) fy = (int64_t)(src_rect->h - 1) << 16;
+        int sy = (int)(fy >> 16);
+        uint32_t wy = (fy >> 8) & 0xFF;
+        const uint8_t *s0 = jw_buffer_at(src, src_rect->x, src_rect->y + sy);
+        const uint8_t *s1 = jw_buffer_at(src, src_rect->x, src_rect->y + (sy < src_rect->h - 1 ? sy + 1 : sy));
+        uint8_t *d = jw_buffer_at(dst, c.x, c.y + y);
+
+        for (int x = 0; x < c.w; x++, d += dbpp) {
+            int x0 = xs[x];
+            int x1 = x0 < max_x ? x0 + 1 : x0;
+            uint32_t top = lerp_swar(load_pixel(s0 + x0 * sbpp, src->format), load_pixel(s0 + x1 * sbpp, src->format), wx[x]);
+            uint32_t bot = lerp_swar(load_pixel(s1 + x0 * sbpp, src->format), load_pixel(s1 + x1 * sbpp, src->format), wx[x]);
+            put_pixel(d, dst->format, lerp_swar(top, bot, wy), mode, alpha);
+        }
+    }
+}
+
+static int soft_scale(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                      jw_buffer_t *dst, const jw_rect_t *dst_rect, const jw_rect_t *clip,
+                      jw_filter_t filter, jw_blend_mode_t mode, uint8_t alpha) {
+    (void)acc;
+    jw_rect_t c;
+    if (jw_rect_empty(src_rect) || !jw_rect_intersect(dst_rect, clip, &c)) return 0;
+    if (jw_format_opaque(src->format) && alpha == 255) mode = JW_BLEND_NONE;
+
+    for (int x = 0; x < c.w; x += JW_SCALE_MAX_SPAN) {
+        jw_rect_t span = { c.x + x, c.y, c.w - x < JW_SCALE_MAX_SPAN ? c.w - x : JW_SCALE_MAX_SPAN, c.h };
+        scale_span(src, src_rect, dst, dst_rect, span, filter, mode, alpha);
+    }
+    return 0;
+}
+
+// Rotation walks the source in square tiles: one tile of source rows and the
+// matching tile of destination columns both stay in L1, instead of striding a
+// full destination column per source row and missing on every write.
+#define JW_ROTATE_TILE 32
+
+#define JW_ROTATE_KERNEL(type)                                                          \
+    do {                                                                                \
+        int dst_step = dst->stride / (int)sizeof(type);                                 \
+        for (int y = ty; y < ty + th; y++) {                                            \
+            const type *s = (const type*)jw_buffer_line(src, y);                        \
+            type *d;                                                                    \
+            switch (rot) {                                                              \
+                case JW_ROTATE_90: /* (x, y) -> (H-1-y, x): down a dst column */        \
+                    d = (type*)jw_buffer_line(dst, tx) + (src->h - 1 - y);              \
+                    for (int x = tx; x < tx + tw; x++, d += dst_step) *d = s[x];        \
+                    break;                                                              \
+                case JW_ROTATE_180:                                                     \
+                    d = (type*)jw_buffer_line(dst, src->h - 1 - y) + (src->w - 1 - tx); \
+                    for (int x = tx; x < tx + tw; x++, d--) *d = s[x];                  \
+                    break;                                                              \
+                default: /* 270: (x, y) -> (y, W-1-x): up a dst column */              \
+                    d = (type*)jw_buffer_line(dst, src->w - 1 - tx) + y;                \
+                    for (int x = tx; x < tx + tw; x++, d -= dst_step) *d = s[x];        \
+                    break;                                                              \
+            }                                                                           \
+        }                                                                               \
+    } while (0)
+
+static int soft_rotate(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                       jw_buffer_t *dst, jw_rotation_t rot) {
+    if (rot == JW_ROTATE_0) {
+        return soft_blit(acc, src, src_rect, dst, src_rect);
+    }
+    if (src->format != dst->format || rot > JW_ROTATE_270) return -1;
+
+    int bpp = jw_format_bpp(src->format);
+    for (int ty = src_rect->y; ty < src_rect->y + src_rect->h; ty += JW_ROTATE_TILE) {
+        int th = src_rect->y + src_rect->h - ty;
+        if (th > JW_ROTATE_TILE) th = JW_ROTATE_TILE;
+
+        for (int tx = src_rect->x; tx < src_rect->x + src_rect->w; tx += JW_ROTATE_TILE) {
+            int tw = src_rect->x + src_rect->w - tx;
+            if (tw > JW_ROTATE_TILE) tw = JW_ROTATE_TILE;
+
+            if (bpp == 4) JW_ROTATE_KERNEL(uint32_t);
+            else if (bpp == 2) JW_ROTATE_KERNEL(uint16_t);
+            else JW_ROTATE_KERNEL(uint8_t);
+        }
+    }
+    return 0;
+}
+
+/*
+ * Worker pool
+ *
+ * Every queued job is run by every worker, each on its own band of rows, so
+ * no locking is needed around the pixels: a worker only ever touches rows of
+ * its band. Jobs split by destination rows, except rotation which splits by
+ * source rows: its source is the composition target, and those rows were
+ * written by the same worker earlier in the queue.
+ */
+
+#define JW_SOFT_MAX_WORKERS 8
+#define JW_SOFT_QUEUE_LEN   256
+
+typedef enum {
+    JOB_FILL_RECT,
+    JOB_BLEND_RECT,
+    JOB_GRADIENT,
+    JOB_BLIT,
+    JOB_BLEND,
+    JOB_BLEND_MASK,
+    JOB_SCALE,
+    JOB_ROTATE
+} soft_job_type_t;
+
+typedef struct soft_job {
+    soft_job_type_t type;
+    jw_buffer_t src, dst;
+    jw_rect_t src_rect, dst_rect, clip;
+    uint32_t color;
+    uint8_t alpha;
+    jw_blend_mode_t mode;
+    jw_filter_t filter;
+    jw_rotation_t rot;
+    jw_gradient_t grad;
+} soft_job_t;
+
+struct jw_fence {
+    uint64_t seq;               // signalled once this many jobs are done
+    int fd;                     // read end, -1 until exported
+    int signal_fd;              // write end (the same eventfd on Linux)
+    struct jw_fence *next;      // exported and still pending
+};
+
+typedef struct soft_accel {
+    jw_accelerator_t base;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;        // jobs queued or stopping
+    pthread_cond_t progress;    // a worker finished a job
+
+    soft_job_t jobs[JW_SOFT_QUEUE_LEN];
+    uint64_t queued;
+    uint64_t finished[JW_SOFT_MAX_WORKERS];
+    jw_fence_t *pending;
+
+    int workers;                // 0: run inline
+    pthread_t threads[JW_SOFT_MAX_WORKERS];
+    bool stop;
+} soft_accel_t;
+
+// Rows [y0, y1) of `rows` that belong to band k of n
+static void band_rows(int rows, int k, int n, int *y0, int *y1) {
+    *y0 = (int)((int64_t)rows * k / n);
+    *y1 = (int)((int64_t)rows * (k + 1) / n);
+}
+
+// Cut a src/dst rect pair to the destination rows [y0, y1)
+static bool band_pair(const jw_rect_t *src_rect, const jw_rect_t *dst_rect, int y0, int y1,
+                      jw_rect_t *src_band, jw_rect_t *dst_band) {
+    int top = dst_rect->y > y0 ? dst_rect->y : y0;
+    int bottom = dst_rect->y + src_rect->h < y1 ? dst_rect->y + src_rect->h : y1;
+    if (bottom <= top) return false;
+    *dst_band = *dst_rect;
+    dst_band->y = top;
+    *src_band = *src_rect;
+    src_band->y = src_rect->y + (top - dst_rect->y);
+    src_band->h = bottom - top;
+    return true;
+}
+
+static void run_job(jw_accelerator_t *acc, soft_job_t *job, int k, int n) {
+    int y0, y1;
+    band_rows(job->type == JOB_ROTATE ? job->src.h : job->dst.h, k, n, &y0, &y1);
+    jw_rect_t band = { 0, y0, job->type == JOB_ROTATE ? job->src.w : job->dst.w, y1 - y0 };
+    jw_rect_t r, sr, dr;
+
+    switch (job->type) {
+        case JOB_FILL_RECT:
+            if (jw_rect_intersect(&job->dst_rect, &band, &r)) soft_fill_rect(acc, &job->dst, &r, job->color);
+            break;
+        case JOB_BLEND_RECT:
+            if (jw_rect_intersect(&job->dst_rect, &band, &r)) soft_blend_rect(acc, &job->dst, &r, job->color, job->alpha);
+            break;
+        case JOB_GRADIENT:
+            if (jw_rect_intersect(&job->dst_rect, &band, &r)) soft_gradient(acc, &job->dst, &r, &job->grad);
+            break;
+        case JOB_BLIT:
+            if (band_pair(&job->src_rect, &job->dst_rect, y0, y1, &sr, &dr)) soft_blit(acc, &job->src, &sr, &job->dst, &dr);
+            break;
+        case JOB_BLEND:
+            if (band_pair(&job->src_rect, &job->dst_rect, y0, y1, &sr, &dr))
+                soft_blend(acc, &job->src, &sr, &job->dst, &dr, job->mode, job->alpha);
+            break;
+        case JOB_BLEND_MASK:
+            if (band_pair(&job->src_rect, &job->dst_rect, y0, y1, &sr, &dr))
+                soft_blend_mask(acc, &job->src, &sr, &job->dst, &dr, job->color, job->alpha);
+            break;
+        case JOB_SCALE:
+            if (jw_rect_intersect(&job->clip, &band, &r))
+                soft_scale(acc, &job->src, &job->src_rect, &job->dst, &job->dst_rect, &r, job->filter, job->mode, job->alpha);
+            break;
+        case JOB_ROTATE:
+            if (jw_rect_intersect(&job->src_rect, &band, &r)) soft_rotate(acc, &job->src, &r, &job->dst, job->rot);
+            break;
+    }
+}
+
+// Jobs every worker is done with, callers hold the lock
+static uint64_t completed_locked(const soft_accel_t *soft) {
+    if (soft->workers == 0) return soft->queued;
+    uint64_t done = soft->finished[0];
+    for (int k = 1; k < soft->workers; k++) {
+        if (soft->finished[k] < done) done = soft->finished[k];
+    }
+    return done;
+}
+
+static int open_fence_fd(jw_fence_t *fence) {
+#ifdef __linux__
+    fence->fd = fence->signal_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    return fence->fd;
+#else
+    int fds[2];
+    if (pipe(fds) == -1) return -1;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    fence->fd = fds[0];
+    fence->signal_fd = fds[1];
+    return fence->fd;
+#endif
+}
+
+static void signal_fence(jw_fence_t *fence) {
+    uint64_t one = 1;
+    if (write(fence->signal_fd, &one, sizeof(one)) != sizeof(one)) perror("fence signal");
+}
+
+static void signal_fences_locked(soft_accel_t *soft) {
+    uint64_t done = completed_locked(soft);
+    jw_fence_t **link = &soft->pending;
+    while (*link) {
+        if ((*link)->seq <= done) {
+            signal_fence(*link);
+            *link = (*link)->next;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+}
+
+typedef struct {
+    soft_accel_t *soft;
+    int index;
+} soft_worker_arg_t;
+
+static void *soft_worker(void *p) {
+    soft_worker_arg_t arg = *(soft_worker_arg_t*)p;
+    free(p);
+    soft_accel_t *soft = arg.soft;
+    int k = arg.index;
+
+    pthread_mutex_lock(&soft->lock);
+    for (;;) {
+        while (!soft->stop && soft->finished[k] == soft->queued) {
+            pthread_cond_wait(&soft->work, &soft->lock);
+        }
+        if (soft->finished[k] == soft->queued) break; // stopping and drained
+
+        // The slot cannot be reused before this worker is done with it
+        soft_job_t *job = &soft->jobs[soft->finished[k] % JW_SOFT_QUEUE_LEN];
+        pthread_mutex_unlock(&soft->lock);
+        run_job(&soft->base, job, k, soft->workers);
+        pthread_mutex_lock(&soft->lock);
+
+        soft->finished[k]++;
+        signal_fences_locked(soft);
+        pthread_cond_broadcast(&soft->progress);
+    }
+    pthread_mutex_unlock(&soft->lock);
+    return NULL;
+}
+
+static int submit(jw_accelerator_t *acc, const soft_job_t *job) {
+    soft_accel_t *soft = (soft_accel_t*)acc;
+    if (soft->workers == 0) {
+        soft_job_t copy = *job;
+        run_job(acc, &copy, 0, 1);
+        return 0;
+    }
+
+    pthread_mutex_lock(&soft->lock);
+    while (soft->queued - completed_locked(soft) >= JW_SOFT_QUEUE_LEN) {
+        pthread_cond_wait(&soft->progress, &soft->lock);
+    }
+    soft->jobs[soft->queued % JW_SOFT_QUEUE_LEN] = *job;
+    soft->queued++;
+    pthread_cond_broadcast(&soft->work);
+    pthread_mutex_unlock(&soft->lock);
+    return 0;
+}
+
+static int async_fill_rect(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, uint32_t color) {
+    soft_job_t job = { .type = JOB_FILL_RECT, .dst = *dst, .dst_rect = *rect, .color = color };
+    return submit(acc, &job);
+}
+
+static int async_blend_rect(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, uint32_t color, uint8_t alpha) {
+    soft_job_t job = { .type = JOB_BLEND_RECT, .dst = *dst, .dst_rect = *rect, .color = color, .alpha = alpha };
+    return submit(acc, &job);
+}
+
+static int async_gradient(jw_accelerator_t *acc, jw_buffer_t *dst, const jw_rect_t *rect, const jw_gradient_t *grad) {
+    soft_job_t job = { .type = JOB_GRADIENT, .dst = *dst, .dst_rect = *rect, .grad = *grad };
+    return submit(acc, &job);
+}
+
+static int async_blit(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                      jw_buffer_t *dst, const jw_rect_t *dst_rect) {
+    soft_job_t job = { .type = JOB_BLIT, .src = *src, .src_rect = *src_rect, .dst = *dst, .dst_rect = *dst_rect };
+    return submit(acc, &job);
+}
+
+static int async_blend(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                       jw_buffer_t *dst, const jw_rect_t *dst_rect, jw_blend_mode_t mode, uint8_t alpha) {
+    soft_job_t job = { .type = JOB_BLEND, .src = *src, .src_rect = *src_rect, .dst = *dst, .dst_rect = *dst_rect,
+                       .mode = mode, .alpha = alpha };
+    return submit(acc, &job);
+}
+
+static int async_blend_mask(jw_accelerator_t *acc, const jw_buffer_t *mask, const jw_rect_t *src_rect,
+                            jw_buffer_t *dst, const jw_rect_t *dst_rect, uint32_t color, uint8_t alpha) {
+    if (mask->format != JW_FORMAT_A8) return -1;
+    soft_job_t job = { .type = JOB_BLEND_MASK, .src = *mask, .src_rect = *src_rect, .dst = *dst, .dst_rect = *dst_rect,
+                       .color = color, .alpha = alpha };
+    return submit(acc, &job);
+}
+
+static int async_scale(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                       jw_buffer_t *dst, const jw_rect_t *dst_rect, const jw_rect_t *clip,
+                       jw_filter_t filter, jw_blend_mode_t mode, uint8_t alpha) {
+    jw_rect_t c;
+    if (!jw_rect_intersect(dst_rect, clip, &c)) return 0;
+    soft_job_t job = { .type = JOB_SCALE, .src = *src, .src_rect = *src_rect, .dst = *dst, .dst_rect = *dst_rect,
+                       .clip = c, .filter = filter, .mode = mode, .alpha = alpha };
+    return submit(acc, &job);
+}
+
+static int async_rotate(jw_accelerator_t *acc, const jw_buffer_t *src, const jw_rect_t *src_rect,
+                        jw_buffer_t *dst, jw_rotation_t rot) {
+    if (src->format != dst->format || rot > JW_ROTATE_270) return -1;
+    soft_job_t job = { .type = JOB_ROTATE, .src = *src, .src_rect = *src_rect, .dst = *dst, .rot = rot };
+    return submit(acc, &job);
+}
+
+static jw_fence_t *soft_fence(jw_accelerator_t *acc) {
+    soft_accel_t *soft = (soft_accel_t*)acc;
+    jw_fence_t *fence = (jw_fence_t*)calloc(1, sizeof(jw_fence_t));
+    if (!fence) return NULL;
+    fence->fd = fence->signal_fd = -1;
+    pthread_mutex_lock(&soft->lock);
+    fence->seq = soft->queued;
+    pthread_mutex_unlock(&soft->lock);
+    return fence;
+}
+
+static int soft_fence_wait(jw_accelerator_t *acc, jw_fence_t *fence, int timeout_ms) {
+    soft_accel_t *soft = (soft_accel_t*)acc;
+    if (!fence) return -1;
+
+    struct timespec deadline;
+    if (timeout_ms > 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    int ret = 0;
+    pthread_mutex_lock(&soft->lock);
+    while (completed_locked(soft) < fence->seq) {
+        if (timeout_ms == 0) {
+            ret = 1;
+            break;
+        }
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&soft->progress, &soft->lock);
+        } else if (pthread_cond_timedwait(&soft->progress, &soft->lock, &deadline) == ETIMEDOUT) {
+            ret = completed_locked(soft) < fence->seq ? 1 : 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&soft->lock);
+    return ret;
+}
+
+static int soft_fence_fd(jw_accelerator_t *acc, jw_fence_t *fence) {
+    soft_accel_t *soft = (soft_accel_t*)acc;
+    if (!fence) return -1;
+
+    pthread_mutex_lock(&soft->lock);
+    if (fence->fd < 0) {
+        if (open_fence_fd(fence) >= 0) {
+            if (completed_locked(soft) >= fence->seq) {
+                signal_fence(fence);
+            } else {
+                fence->next = soft->pending;
+                soft->pending = fence;
+            }
+        }
+    }
+    pthread_mutex_unlock(&soft->lock);
+    return fence->fd;
+}
+
+static void soft_fence_release(jw_accelerator_t *acc, jw_fence_t *fence) {
+    soft_accel_t *soft = (soft_accel_t*)acc;
+    if (!fence) return;
+
+    pthread_mutex_lock(&soft->lock);
+    for (jw_fence_t **link = &soft->pending; *link; link = &(*link)->next) {
+        if (*link == fence) {
+            *link = fence->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&soft->lock);
+    if (fence->fd >= 0) close(fence->fd);
+    if (fence->signal_fd >= 0 && fence->signal_fd != fence->fd) close(fence->signal_fd);
+    free(fence);
+}
+
+static int soft_sync(jw_accelerator_t *acc) {
+    jw_fence_t *fence = soft_fence(acc);
+    if (!fence) return -1;
+    int ret = soft_fence_wait(acc, fence, -1);
+    soft_fence_release(acc, fence);
+    return ret;
+}
+
+static const struct jw_accelerator_ops soft_ops = {
+    .fill_rect = async_fill_rect,
+    .blend_rect = async_blend_rect,
+    .gradient = async_gradient,
+    .blit = async_blit,
+    .blend = async_blend,
+    .blend_mask = async_blend_mask,
+    .scale = async_scale,
+    .rotate = async_rotate,
+    .sync = soft_sync,
+    .fence = soft_fence,
+    .fence_wait = soft_fence_wait,
+    .fence_fd = soft_fence_fd,
+    .fence_release = soft_fence_release,
+};
+
+static int default_workers(void) {
+    const char *env = getenv("JW_SOFT_THREADS");
+    long n = env ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 0) n = 1;
+    if (n > JW_SOFT_MAX_WORKERS) n = JW_SOFT_MAX_WORKERS;
+    return (int)n;
+}
+
+jw_accelerator_t *jw_accel_soft_create(void) {
+    soft_accel_t *soft = (soft_accel_t*)calloc(1, sizeof(soft_accel_t));
+    if (!soft) return NULL;
+    soft->base.ops = &soft_ops;
+    soft->base.name = "soft";
+    pthread_mutex_init(&soft->lock, NULL);
+    pthread_cond_init(&soft->work, NULL);
+    pthread_cond_init(&soft->progress, NULL);
+
+    int wanted = default_workers();
+    for (int k = 0; k < wanted; k++) {
+        soft_worker_arg_t *arg = (soft_worker_arg_t*)malloc(sizeof(soft_worker_arg_t));
+        if (!arg) break;
+        arg->soft = soft;
+        arg->index = k;
+        // Bump the count first, a started worker reads it for its band
+        soft->workers = k + 1;
+        if (pthread_create(&soft->threads[k], NULL, soft_worker, arg) != 0) {
+            soft->workers = k;
+            free(arg);
+            break;
+        }
+    }
+    return &soft->base;
+}
+
+void jw_accel_soft_destroy(jw_accelerator_t *acc) {
+    soft_accel_t *soft = (soft_accel_t*)acc;
+    if (!soft) return;
+
+    pthread_mutex_lock(&soft->lock);
+    soft->stop = true;
+    pthread_cond_broadcast(&soft->work);
+    pthread_mutex_unlock(&soft->lock);
+    for (int k = 0; k < soft->workers; k++) {
+        pthread_join(soft->threads[k], NULL);
+    }
+
+    pthread_cond_destroy(&soft->work);
+    pthread_cond_destroy(&soft->progress);
+    pthread_mutex_destroy(&soft->lock);
+    free(soft);
+}
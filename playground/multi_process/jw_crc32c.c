@@ -0,0 +1,194 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_crc32c.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#include "jw_crc32c.h"
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define JW_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__GNUC__) && (defined(__ARM_FEATURE_CRC32) || defined(__linux__))
+#define JW_CRC32C_ARMV8 1
+#include <arm_acle.h>
+#if !defined(__ARM_FEATURE_CRC32)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+#define POLY 0x82F63B78u // reflected
+
+// k_table[k][b]: CRC of byte b followed by k zero bytes
+static uint32_t k_table[8][256];
+
+// Long runs go through the CRC instruction as three independent streams of
+// HW_BLOCK bytes, its latency hides behind the other two. k_shift advances a
+// CRC over HW_BLOCK zero bytes, which joins the streams.
+#define HW_BLOCK 256
+static uint32_t k_shift[4][256];
+
+static inline uint32_t shift_block(uint32_t c) {
+    return k_shift[0][c & 0xFF] ^ k_shift[1][(c >> 8) & 0xFF] ^ k_shift[2][(c >> 16) & 0xFF] ^ k_shift[3][c >> 24];
+}
+
+uint32_t jw_crc32c_table(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    crc = ~crc;
+    for (; len && ((uintptr_t)p & 7); len--) crc = k_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    for (; len >= 8; len -= 8, p += 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4); // little endian, like the wire format
+        memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = k_table[7][lo & 0xFF] ^ k_table[6][(lo >> 8) & 0xFF] ^
+              k_table[5][(lo >> 16) & 0xFF] ^ k_table[4][lo >> 24] ^
+              k_table[3][hi & 0xFF] ^ k_table[2][(hi >> 8) & 0xFF] ^
+              k_table[1][(hi >> 16) & 0xFF] ^ k_table[0][hi >> 24];
+    }
+    for (; len; len--) crc = k_table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#if JW_CRC32C_SSE42
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_hw(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    uint64_t c = ~crc, v0, v1, v2;
+    for (; len >= 3 * HW_BLOCK; len -= 3 * HW_BLOCK, p += 3 * HW_BLOCK) {
+        uint64_t c1 = 0, c2 = 0;
+        for (int i = 0; i < HW_BLOCK; i += 8) {
+            memcpy(&v0, p + i, 8);
+            memcpy(&v1, p + HW_BLOCK + i, 8);
+            memcpy(&v2, p + 2 * HW_BLOCK + i, 8);
+            c = _mm_crc32_u64(c, v0);
+            c1 = _mm_crc32_u64(c1, v1);
+            c2 = _mm_crc32_u64(c2, v2);
+        }
+        c = shift_block(shift_block((uint32_t)c) ^ (uint32_t)c1) ^ (uint32_t)c2;
+    }
+    // Unaligned loads are as fast, messages are short
+    for (; len >= 8; len -= 8, p += 8) {
+        memcpy(&v0, p, 8);
+        c = _mm_crc32_u64(c, v0);
+    }
+    uint32_t c32 = (uint32_t)c;
+    if (len >= 4) {
+        uint32_t w;
+        memcpy(&w, p, 4);
+        c32 = _mm_crc32_u32(c32, w);
+        p += 4;
+        len -= 4;
+    }
+    for (; len; len--) c32 = _mm_crc32_u8(c32, *p++);
+    return ~c32;
+}
+
+static int hw_available(void) {
+    return __builtin_cpu_supports("sse4.2");
+}
+
+#define HW_NAME "sse4.2"
+
+#elif JW_CRC32C_ARMV8
+
+#if !defined(__ARM_FEATURE_CRC32)
+__attribute__((target("+crc")))
+#endif
+static uint32_t crc32c_hw(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t*)data;
+    uint64_t v0, v1, v2;
+    crc = ~crc;
+    for (; len >= 3 * HW_BLOCK; len -= 3 * HW_BLOCK, p += 3 * HW_BLOCK) {
+        uint32_t c1 = 0, c2 = 0;
+        for (int i = 0; i < HW_BLOCK; i += 8) {
+            memcpy(&v0, p + i, 8);
+            memcpy(&v1, p + HW_BLOCK + i, 8);
+            memcpy(&v2, p + 2 * HW_BLOCK + i, 8);
+            crc = __crc32cd(crc, v0);
+            c1 = __crc32cd(c1, v1);
+            c2 = __crc32cd(c2, v2);
+        }
+        crc = shift_block(shift_block(crc) ^ c1) ^ c2;
+    }
+    for (; len >= 8; len -= 8, p += 8) {
+        memcpy(&v0, p, 8);
+        crc = __crc32cd(crc, v0);
+    }
+    if (len >= 4) {
+        uint32_t w;
+        memcpy(&w, p, 4);
+        crc = __crc32cw(crc, w);
+        p += 4;
+        len -= 4;
+    }
+    for (; len; len--) crc = __crc32cb(crc, *p++);
+    return ~crc;
+}
+
+static int hw_available(void) {
+#if defined(__ARM_FEATURE_CRC32)
+    return 1;
+#else
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif
+}
+
+#define HW_NAME "armv8"
+
+#endif
+
+static uint32_t (*g_crc32c)(uint32_t, const void*, size_t) = jw_crc32c_table;
+static const char *g_impl = "table";
+
+// Before main(), so no caller races the choice
+__attribute__((constructor))
+static void crc32c_init(void) {
+    for (uint32_t b = 0; b < 256; b++) {
+        uint32_t c = b;
+        for (int k = 0; k < 8; k++) c = (c >> 1) ^ (POLY & (0u - (c & 1)));
+        k_table[0][b] = c;
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+        for (int k = 1; k < 8; k++) k_table[k][b] = k_table[0][k_table[k - 1][b] & 0xFF] ^ (k_table[k - 1][b] >> 8);
+    }
+#if JW_CRC32C_SSE42 || JW_CRC32C_ARMV8
+    // Running a CRC register (not inverted) over zero bytes is linear in it:
+    // shift each bit once, the table entries are sums of those
+    uint32_t bit[32];
+    for (int j = 0; j < 32; j++) {
+        uint32_t c = 1u << j;
+        for (int i = 0; i < HW_BLOCK; i++) c = k_table[0][c & 0xFF] ^ (c >> 8);
+        bit[j] = c;
+    }
+    for (int k = 0; k < 4; k++) {
+        for (uint32_t b = 0; b < 256; b++) {
+            uint32_t c = 0;
+            for (int j = 0; j < 8; j++) c ^= (b >> j & 1) ? bit[8 * k + j] : 0;
+            k_shift[k][b] = c;
+        }
+    }
+    if (hw_available()) {
+        g_crc32c = crc32c_hw;
+        g_impl = HW_NAME;
+    }
+#endif
+}
+
+uint32_t jw_crc32c(uint32_t crc, const void *data, size_t len) {
+    return g_crc32c(crc, data, len);
+}
+
+const char *jw_crc32c_impl(void) {
+    return g_impl;
+}
@@ -0,0 +1,45 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_crc32c.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_CRC32C_H
+#define JW_MT_CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * CRC32C (Castagnoli, the polynomial of iSCSI and ext4) for message integrity.
+ *
+ * The CPU's CRC32 instructions are used where it has them (SSE4.2 on x86-64,
+ * the ARMv8 CRC extension on aarch64), picked once at startup; elsewhere a
+ * slicing-by-8 table does eight bytes per step. All give the same result.
+ */
+
+// CRC of len bytes continuing from crc, 0 to start a new one
+uint32_t jw_crc32c(uint32_t crc, const void *data, size_t len);
+
+// Always the table version, to compare against
+uint32_t jw_crc32c_table(uint32_t crc, const void *data, size_t len);
+
+// "sse4.2", "armv8" or "table", what jw_crc32c() runs on
+const char *jw_crc32c_impl(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_CRC32C_H
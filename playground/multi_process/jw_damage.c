@@ -0,0 +1,200 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_damage.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#include "jw_damage.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Two 64-bit lanes over 16-byte blocks, XXH3 style: per block
+//   acc += lo32(data ^ key) * hi32(data ^ key) + data with its lanes swapped
+// and a scramble at the end of each row so rows do not commute.
+#define PRIME32 0x9E3779B1u
+
+static const uint64_t k_secret[18] = {
+    0x6e789e6aa1b965f4ull, 0x06c45d188009454full, 0xf88bb8a8724c81ecull,
+    0x1b39896a51a8749bull, 0x53cb9f0c747ea2eaull, 0x2c829abe1f4532e1ull,
+    0xc584133ac916ab3cull, 0x3ee5789041c98ac3ull, 0xf3b8488c368cb0a6ull,
+    0x657eecdd3cb13d09ull, 0xc2d326e0055bdef6ull, 0x8621a03fe0bbdb7bull,
+    0x8e1f7555983aa92full, 0xb54e0f1600cc4d19ull, 0x84bb3f97971d80abull,
+    0x7d29825c75521255ull, 0xc3cf17102b7f7f86ull, 0x3466e9a083914f64ull,
+};
+#define SCRAMBLE_KEY (k_secret + 16)
+
+static uint64_t avalanche(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+#if defined(__SSE2__)
+
+static inline __m128i block(__m128i acc, const uint8_t *p, const uint64_t *key) {
+    __m128i data = _mm_loadu_si128((const __m128i*)p);
+    __m128i dk = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)key));
+    acc = _mm_add_epi64(acc, _mm_mul_epu32(dk, _mm_srli_epi64(dk, 32)));
+    return _mm_add_epi64(acc, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+static inline __m128i scramble(__m128i acc) {
+    acc = _mm_xor_si128(acc, _mm_srli_epi64(acc, 47));
+    acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i*)SCRAMBLE_KEY));
+    __m128i prime = _mm_set1_epi32((int)PRIME32);
+    __m128i lo = _mm_mul_epu32(acc, prime);
+    __m128i hi = _mm_mul_epu32(_mm_srli_epi64(acc, 32), prime);
+    return _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+}
+
+uint64_t jw_damage_hash(const void *pixels, int stride, int row_bytes, int rows) {
+    __m128i acc = _mm_set_epi64x((long long)k_secret[1], (long long)k_secret[0]);
+    const uint8_t *row = (const uint8_t*)pixels;
+    for (int y = 0; y < rows; y++, row += stride) {
+        int x = 0, b = 0;
+        for (; x + 16 <= row_bytes; x += 16, b++) acc = block(acc, row + x, k_secret + (b & 7) * 2);
+        if (x < row_bytes) {
+            uint8_t tail[16] = {0};
+            memcpy(tail, row + x, (size_t)(row_bytes - x));
+            acc = block(acc, tail, k_secret + (b & 7) * 2);
+        }
+        acc = scramble(acc);
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i*)lanes, acc);
+    return avalanche(lanes[0] ^ (lanes[1] << 31 | lanes[1] >> 33) ^ (uint64_t)row_bytes * (uint64_t)rows);
+}
+
+#elif defined(__ARM_NEON)
+
+static inline uint64x2_t block(uint64x2_t acc, const uint8_t *p, const uint64_t *key) {
+    uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(p));
+    uint64x2_t dk = veorq_u64(data, vld1q_u64(key));
+    acc = vaddq_u64(acc, vmull_u32(vmovn_u64(dk), vshrn_n_u64(dk, 32)));
+    return vaddq_u64(acc, vextq_u64(data, data, 1));
+}
+
+static inline uint64x2_t scramble(uint64x2_t acc) {
+    acc = veorq_u64(acc, vshrq_n_u64(acc, 47));
+    acc = veorq_u64(acc, vld1q_u64(SCRAMBLE_KEY));
+    uint32x2_t prime = vdup_n_u32(PRIME32);
+    uint64x2_t lo = vmull_u32(vmovn_u64(acc), prime);
+    uint64x2_t hi = vmull_u32(vshrn_n_u64(acc, 32), prime);
+    return vaddq_u64(lo, vshlq_n_u64(hi, 32));
+}
+
+uint64_t jw_damage_hash(const void *pixels, int stride, int row_bytes, int rows) {
+    uint64x2_t acc = vld1q_u64(k_secret);
+    const uint8_t *row = (const uint8_t*)pixels;
+    for (int y = 0; y < rows; y++, row += stride) {
+        int x = 0, b = 0;
+        for (; x + 16 <= row_bytes; x += 16, b++) acc = block(acc, row + x, k_secret + (b & 7) * 2);
+        if (x < row_bytes) {
+            uint8_t tail[16] = {0};
+            memcpy(tail, row + x, (size_t)(row_bytes - x));
+            acc = block(acc, tail, k_secret + (b & 7) * 2);
+        }
+        acc = scramble(acc);
+    }
+    uint64_t lanes[2];
+    vst1q_u64(lanes, acc);
+    return avalanche(lanes[0] ^ (lanes[1] << 31 | lanes[1] >> 33) ^ (uint64_t)row_bytes * (uint64_t)rows);
+}
+
+#else
+
+static inline void block(uint64_t acc[2], const uint8_t *p, const uint64_t *key) {
+    uint64_t data[2];
+    memcpy(data, p, sizeof(data));
+    for (int i = 0; i < 2; i++) {
+        uint64_t dk = data[i] ^ key[i];
+        acc[i] += (dk & 0xFFFFFFFFull) * (dk >> 32) + data[i ^ 1];
+    }
+}
+
+static inline void scramble(uint64_t acc[2]) {
+    for (int i = 0; i < 2; i++) {
+        uint64_t a = acc[i] ^ (acc[i] >> 47) ^ SCRAMBLE_KEY[i];
+        acc[i] = (a & 0xFFFFFFFFull) * PRIME32 + (((a >> 32) * PRIME32) << 32);
+    }
+}
+
+uint64_t jw_damage_hash(const void *pixels, int stride, int row_bytes, int rows) {
+    uint64_t acc[2] = { k_secret[0], k_secret[1] };
+    const uint8_t *row = (const uint8_t*)pixels;
+    for (int y = 0; y < rows; y++, row += stride) {
+        int x = 0, b = 0;
+        for (; x + 16 <= row_bytes; x += 16, b++) block(acc, row + x, k_secret + (b & 7) * 2);
+        if (x < row_bytes) {
+            uint8_t tail[16] = {0};
+            memcpy(tail, row + x, (size_t)(row_bytes - x));
+            block(acc, tail, k_secret + (b & 7) * 2);
+        }
+        scramble(acc);
+    }
+    return avalanche(acc[0] ^ (acc[1] << 31 | acc[1] >> 33) ^ (uint64_t)row_bytes * (uint64_t)rows);
+}
+
+#endif
+
+int jw_damage_detect(jw_tile_hashes_t *tiles, const jw_buffer_t *buf, jw_rect_t *changed) {
+    memset(changed, 0, sizeof(*changed));
+    int cols = (buf->w + JW_DAMAGE_TILE - 1) / JW_DAMAGE_TILE;
+    int rows = (buf->h + JW_DAMAGE_TILE - 1) / JW_DAMAGE_TILE;
+    jw_rect_t whole = { 0, 0, buf->w, buf->h };
+
+    bool fresh = !tiles->valid || tiles->w != buf->w || tiles->h != buf->h || tiles->format != buf->format;
+    if (fresh && cols * rows != tiles->cols * tiles->rows) {
+        uint64_t *grown = (uint64_t*)realloc(tiles->hash, (size_t)cols * rows * sizeof(uint64_t));
+        if (!grown && cols * rows > 0) {
+            tiles->valid = false;
+            *changed = whole;
+            return cols * rows;
+        }
+        tiles->hash = grown;
+    }
+    tiles->w = buf->w;
+    tiles->h = buf->h;
+    tiles->cols = cols;
+    tiles->rows = rows;
+    tiles->format = buf->format;
+    tiles->valid = true;
+
+    int bpp = jw_format_bpp(buf->format);
+    int count = 0;
+    for (int ty = 0; ty < rows; ty++) {
+        for (int tx = 0; tx < cols; tx++) {
+            jw_rect_t t = { tx * JW_DAMAGE_TILE, ty * JW_DAMAGE_TILE, JW_DAMAGE_TILE, JW_DAMAGE_TILE };
+            if (t.x + t.w > buf->w) t.w = buf->w - t.x;
+            if (t.y + t.h > buf->h) t.h = buf->h - t.y;
+            uint64_t h = jw_damage_hash(jw_buffer_at(buf, t.x, t.y), buf->stride, t.w * bpp, t.h);
+            uint64_t *old = &tiles->hash[ty * cols + tx];
+            if (!fresh && *old == h) continue;
+            *old = h;
+            jw_rect_union(changed, &t);
+            count++;
+        }
+    }
+    return count;
+}
+
+void jw_damage_free(jw_tile_hashes_t *tiles) {
+    free(tiles->hash);
+    memset(tiles, 0, sizeof(*tiles));
+}
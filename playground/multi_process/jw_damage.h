@@ -0,0 +1,60 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_damage.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_DAMAGE_H
+#define JW_MT_DAMAGE_H
+
+#include "jw_accel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JW_DAMAGE_TILE 32 // pixels, square
+
+/**
+ * Automatic damage for canvases whose client does not say what it changed.
+ *
+ * Every commit the canvas is hashed tile by tile (SSE2 or NEON where
+ * available, the same hash in plain C elsewhere) and compared with the hashes
+ * of the previous commit. A colliding hash would hide a change until the tile
+ * changes again; with 64 bits that is left to chance.
+ */
+typedef struct jw_tile_hashes {
+    int w, h;               // canvas size the hashes were taken at
+    int cols, rows;
+    jw_format_t format;
+    uint64_t *hash;         // cols * rows, row-major
+    bool valid;
+} jw_tile_hashes_t;
+
+// Hash the tiles of buf. Returns the number of tiles that changed since the
+// last call and their bounding rect in *changed; everything counts as changed
+// the first time and after the buffer's size or format changed.
+int jw_damage_detect(jw_tile_hashes_t *tiles, const jw_buffer_t *buf, jw_rect_t *changed);
+
+// Forget the hashes, the next detect reports the whole buffer
+static inline void jw_damage_reset(jw_tile_hashes_t *tiles) {
+    tiles->valid = false;
+}
+
+void jw_damage_free(jw_tile_hashes_t *tiles);
+
+// 64-bit hash of `rows` rows of row_bytes each
+uint64_t jw_damage_hash(const void *pixels, int stride, int row_bytes, int rows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_DAMAGE_H
@@ -0,0 +1,258 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_mem.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include "jw_mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define HEAP_MAX (128u << 10)   // smaller buffers come from the heap, whatever the mode
+#define HUGE_MIN (1u << 20)     // smaller is not worth a huge page
+#define HUGE_PAGE (2u << 20)
+#define ALIGN 64
+
+static unsigned g_mode = 0;
+static jw_mem_stats_t g_stats;
+static unsigned g_reported = 0; // JW_MEM_* whose fallback was reported
+
+enum { KIND_SMALL, KIND_THP, KIND_HUGETLB };
+
+// What each mapping got, so releasing it takes back what it counted
+typedef struct {
+    uintptr_t start, end;
+    uint8_t kind;
+    bool locked;
+} mapping_t;
+
+static pthread_mutex_t g_maps_lock = PTHREAD_MUTEX_INITIALIZER;
+static mapping_t *g_maps;
+static size_t g_map_count, g_map_cap;
+
+static void count(uint64_t *counter, size_t bytes) {
+    __atomic_fetch_add(counter, (uint64_t)bytes, __ATOMIC_RELAXED);
+}
+
+static void uncount(uint64_t *counter, size_t bytes) {
+    __atomic_fetch_sub(counter, (uint64_t)bytes, __ATOMIC_RELAXED);
+}
+
+static uint64_t *kind_bytes(int kind) {
+    if (kind == KIND_HUGETLB) return &g_stats.hugetlb_bytes;
+    return kind == KIND_THP ? &g_stats.thp_advised : &g_stats.small_bytes;
+}
+
+// Untracked (out of memory for the table) mappings are not counted either
+static void track(void *ptr, size_t len, int kind, bool locked) {
+    pthread_mutex_lock(&g_maps_lock);
+    if (g_map_count == g_map_cap) {
+        size_t cap = g_map_cap ? g_map_cap * 2 : 16;
+        mapping_t *maps = (mapping_t*)realloc(g_maps, cap * sizeof(*maps));
+        if (!maps) {
+            pthread_mutex_unlock(&g_maps_lock);
+            return;
+        }
+        g_maps = maps;
+        g_map_cap = cap;
+    }
+    g_maps[g_map_count++] = (mapping_t){ (uintptr_t)ptr, (uintptr_t)ptr + len, (uint8_t)kind, locked };
+    count(kind_bytes(kind), len);
+    if (locked) count(&g_stats.locked_bytes, len);
+    pthread_mutex_unlock(&g_maps_lock);
+}
+
+static void fallback(unsigned what, const char *msg) {
+    __atomic_fetch_add(&g_stats.fallbacks, 1, __ATOMIC_RELAXED);
+    if (__atomic_fetch_or(&g_reported, what, __ATOMIC_RELAXED) & what) return;
+    fprintf(stderr, "jw_mem: %s\n", msg);
+}
+
+static size_t round_up(size_t v, size_t to) {
+    return (v + to - 1) / to * to;
+}
+
+static bool want_huge(size_t size) {
+    return (g_mode & JW_MEM_HUGE) && size >= HUGE_MIN;
+}
+
+static size_t map_len(size_t size) {
+    return round_up(size, want_huge(size) ? HUGE_PAGE : (size_t)sysconf(_SC_PAGESIZE));
+}
+
+static bool lock(void *ptr, size_t size) {
+    if (!(g_mode & JW_MEM_LOCK)) return false;
+    if (mlock(ptr, size) == 0) return true;
+    fallback(JW_MEM_LOCK, "mlock refused (RLIMIT_MEMLOCK?), buffers stay pageable");
+    return false;
+}
+
+static void populate(void *ptr, size_t size) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(ptr, size, MADV_POPULATE_WRITE) == 0) return;
+#endif
+    // Fresh memory reads as zero, so writing zero to each page is harmless
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    for (size_t off = 0; off < size; off += page) ((volatile uint8_t*)ptr)[off] = 0;
+}
+
+void jw_mem_prepare(void *ptr, size_t size) {
+    bool huge = false;
+    if (want_huge(size)) {
+#ifdef MADV_HUGEPAGE
+        huge = madvise(ptr, size, MADV_HUGEPAGE) == 0;
+#endif
+        if (!huge) fallback(JW_MEM_HUGE, "no transparent huge pages, using small pages");
+    }
+    if (g_mode & JW_MEM_POPULATE) populate(ptr, size);
+    bool locked = lock(ptr, size);
+    track(ptr, size, huge ? KIND_THP : KIND_SMALL, locked);
+}
+
+void jw_mem_release(void *ptr) {
+    pthread_mutex_lock(&g_maps_lock);
+    for (size_t i = 0; i < g_map_count; i++) {
+        mapping_t *m = &g_maps[i];
+        if (m->start != (uintptr_t)ptr) continue;
+        size_t len = (size_t)(m->end - m->start);
+        uncount(kind_bytes(m->kind), len);
+        if (m->locked) uncount(&g_stats.locked_bytes, len);
+        *m = g_maps[--g_map_count];
+        break;
+    }
+    pthread_mutex_unlock(&g_maps_lock);
+}
+
+void *jw_mem_alloc(size_t size) {
+    if (size < HEAP_MAX) {
+        void *p = NULL;
+        if (posix_memalign(&p, ALIGN, size ? size : 1) != 0) return NULL;
+        memset(p, 0, size);
+        count(&g_stats.small_bytes, size);
+        return p;
+    }
+
+    size_t len = map_len(size);
+#ifdef MAP_HUGETLB
+    if (want_huge(size)) {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_POPULATE
+        if (g_mode & JW_MEM_POPULATE) flags |= MAP_POPULATE;
+#endif
+        void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p != MAP_FAILED) {
+            bool locked = lock(p, len);
+            track(p, len, KIND_HUGETLB, locked);
+            return p;
+        }
+        fallback(JW_MEM_HUGE, "no MAP_HUGETLB pages reserved (vm.nr_hugepages), trying transparent huge pages");
+    }
+#endif
+
+    uint8_t *p;
+    if (want_huge(size)) {
+        // Huge-page aligned, so the whole buffer can be backed by huge pages
+        size_t span = len + HUGE_PAGE;
+        uint8_t *raw = (uint8_t*)mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return NULL;
+        p = (uint8_t*)round_up((uintptr_t)raw, HUGE_PAGE);
+        if (p > raw) munmap(raw, (size_t)(p - raw));
+        if (p + len < raw + span) munmap(p + len, (size_t)(raw + span - (p + len)));
+    } else {
+        p = (uint8_t*)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return NULL;
+    }
+    jw_mem_prepare(p, len);
+    return p;
+}
+
+void jw_mem_free(void *ptr, size_t size) {
+    if (!ptr) return;
+    if (size < HEAP_MAX) {
+        uncount(&g_stats.small_bytes, size);
+        free(ptr);
+        return;
+    }
+    jw_mem_release(ptr);
+    munmap(ptr, map_len(size));
+}
+
+void jw_mem_set_mode(unsigned mode) {
+    g_mode = mode;
+}
+
+unsigned jw_mem_mode(void) {
+    return g_mode;
+}
+
+int jw_mem_parse_mode(const char *text) {
+    if (strcmp(text, "none") == 0) return 0;
+    int mode = 0;
+    const char *p = text;
+    while (*p) {
+        size_t n = strcspn(p, ",");
+        if (n == 4 && strncmp(p, "huge", n) == 0) mode |= JW_MEM_HUGE;
+        else if (n == 8 && strncmp(p, "populate", n) == 0) mode |= JW_MEM_POPULATE;
+        else if (n == 4 && strncmp(p, "lock", n) == 0) mode |= JW_MEM_LOCK;
+        else return -1;
+        p += n;
+        if (*p == ',') p++;
+    }
+    return mode;
+}
+
+// Bytes of the THP-advised mappings inside [start, end)
+static uint64_t thp_overlap(uintptr_t start, uintptr_t end) {
+    uint64_t bytes = 0;
+    pthread_mutex_lock(&g_maps_lock);
+    for (size_t i = 0; i < g_map_count; i++) {
+        const mapping_t *m = &g_maps[i];
+        if (m->kind != KIND_THP || m->end <= start || m->start >= end) continue;
+        bytes += (m->end < end ? m->end : end) - (m->start > start ? m->start : start);
+    }
+    pthread_mutex_unlock(&g_maps_lock);
+    return bytes;
+}
+
+// Advice is only a hint: what the kernel actually put on huge pages is in
+// smaps, per VMA. A VMA can reach past our mapping, so cap it at the overlap.
+static uint64_t thp_backed(void) {
+    FILE *f = fopen("/proc/self/smaps", "r");
+    if (!f) return 0;
+    char line[256];
+    uint64_t total = 0, overlap = 0;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long start, end, kb;
+        if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            overlap = thp_overlap(start, end);
+        } else if (overlap && (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1 ||
+                               sscanf(line, "ShmemPmdMapped: %lu kB", &kb) == 1)) {
+            uint64_t bytes = (uint64_t)kb << 10;
+            total += bytes < overlap ? bytes : overlap;
+        }
+    }
+    fclose(f);
+    return total;
+}
+
+void jw_mem_get_stats(jw_mem_stats_t *out) {
+    out->hugetlb_bytes = __atomic_load_n(&g_stats.hugetlb_bytes, __ATOMIC_RELAXED);
+    out->thp_advised = __atomic_load_n(&g_stats.thp_advised, __ATOMIC_RELAXED);
+    out->thp_bytes = out->thp_advised ? thp_backed() : 0;
+    out->small_bytes = __atomic_load_n(&g_stats.small_bytes, __ATOMIC_RELAXED);
+    out->locked_bytes = __atomic_load_n(&g_stats.locked_bytes, __ATOMIC_RELAXED);
+    out->fallbacks = __atomic_load_n(&g_stats.fallbacks, __ATOMIC_RELAXED);
+}
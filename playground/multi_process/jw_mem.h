@@ -0,0 +1,72 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_mem.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_MEM_H
+#define JW_MT_MEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Pixel memory: framebuffers, resident resources and shared canvases.
+ *
+ * A full-HD ARGB buffer spans some 2000 small pages, so every composite pass
+ * takes TLB misses and the first frame takes the page faults. The mode, set
+ * once at startup (jw_mt_core --alloc), can ask for huge pages (MAP_HUGETLB,
+ * else transparent huge pages), prefaulting and mlock. Whatever the system
+ * refuses falls back to the next best thing, counted in jw_mem_stats_t and
+ * reported once on stderr.
+ */
+
+#define JW_MEM_HUGE     0x01 // buffers of 1 MB and more on huge pages
+#define JW_MEM_POPULATE 0x02 // fault everything in at allocation, not at first touch
+#define JW_MEM_LOCK     0x04 // mlock, never paged out
+
+// Bytes held now by what they asked for and got, and refusals since startup
+typedef struct jw_mem_stats {
+    uint64_t hugetlb_bytes;  // MAP_HUGETLB
+    uint64_t thp_advised;    // madvise(MADV_HUGEPAGE) took, the kernel may still use small pages
+    uint64_t thp_bytes;      // of those, on huge pages as /proc/self/smaps shows
+    uint64_t small_bytes;    // regular pages
+    uint64_t locked_bytes;
+    uint32_t fallbacks;      // the mode asked for more than it got
+} jw_mem_stats_t;
+
+// Before the first allocation
+void jw_mem_set_mode(unsigned mode);
+unsigned jw_mem_mode(void);
+
+// "huge,populate,lock" (any subset, or "none") to JW_MEM_*, -1 if unknown
+int jw_mem_parse_mode(const char *text);
+
+// Zero-filled, 64-byte aligned. Free with the same size.
+void *jw_mem_alloc(size_t size);
+void jw_mem_free(void *ptr, size_t size);
+
+// The mode for a mapping made elsewhere, such as a shared canvas. Call before
+// anything is written to it, and jw_mem_release before unmapping it.
+void jw_mem_prepare(void *ptr, size_t size);
+void jw_mem_release(void *ptr);
+
+// Reads /proc/self/smaps when anything was advised for THP
+void jw_mem_get_stats(jw_mem_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_MEM_H
@@ -0,0 +1,278 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_mt_capture.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <stdbool.h>
+#include "protocol.h"
+#include "shm_helper.h"
+
+/**
+ * Screen capture through JW_CMD_CAPTURE.
+ *
+ * One-shot by default: the display's output (or --region of it) is written to
+ * --out as a PPM. --stream N follows N changed frames instead and prints the
+ * rects of each; --slow MS holds every frame that long before releasing it,
+ * to watch changes pile up behind a slow consumer.
+ */
+
+static int g_sock = -1;
+static uint16_t g_msg_id = 0;
+static uint8_t g_rx[JW_MSG_MAX_LEN * 2];
+static size_t g_rx_len = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint16_t send_cmd(uint8_t cmd, const void *payload, size_t len, int fd) {
+    uint8_t buf[256];
+    jw_msg_header_t *hdr = (jw_msg_header_t*)buf;
+    hdr->type = JW_MSG_TYPE_CMD;
+    hdr->cmd = cmd;
+    hdr->msg_id = ++g_msg_id;
+    hdr->len = (uint16_t)(sizeof(jw_msg_header_t) + len);
+    memcpy(buf + sizeof(jw_msg_header_t), payload, len);
+    buf[6] = jw_calculate_checksum(buf, hdr->len);
+    send_msg_fd(g_sock, buf, hdr->len, fd);
+    return hdr->msg_id;
+}
+
+// Next whole message into out, events and replies arrive on the same stream
+static size_t next_msg(uint8_t *out) {
+    for (;;) {
+        if (g_rx_len >= sizeof(jw_msg_header_t)) {
+            const jw_msg_header_t *hdr = (const jw_msg_header_t*)g_rx;
+            if (hdr->len < sizeof(jw_msg_header_t) || hdr->len > JW_MSG_MAX_LEN) {
+                fprintf(stderr, "Bad message length %u\n", hdr->len);
+                exit(1);
+            }
+            if (g_rx_len >= hdr->len) {
+                size_t len = hdr->len;
+                memcpy(out, g_rx, len);
+                memmove(g_rx, g_rx + len, g_rx_len - len);
+                g_rx_len -= len;
+                return len;
+            }
+        }
+        int passed = -1;
+        ssize_t n = recv_msg_fd(g_sock, g_rx + g_rx_len, sizeof(g_rx) - g_rx_len, &passed);
+        if (n <= 0) {
+            fprintf(stderr, "Core went away\n");
+            exit(1);
+        }
+        if (passed >= 0) close(passed);
+        g_rx_len += (size_t)n;
+    }
+}
+
+// Wait for the reply to msg_id, a capture frame met on the way goes to *frame
+static const jw_payload_response_t *wait_reply(uint16_t msg_id, uint8_t *msg, uint8_t *frame) {
+    for (;;) {
+        size_t len = next_msg(msg);
+        const jw_msg_header_t *hdr = (const jw_msg_header_t*)msg;
+        if (hdr->type == JW_MSG_TYPE_EVT && hdr->cmd == JW_CMD_CAPTURE && frame) {
+            memcpy(frame, msg, len);
+        } else if (hdr->type == JW_MSG_TYPE_RESP && hdr->msg_id == msg_id) {
+            return (const jw_payload_response_t*)(msg + sizeof(jw_msg_header_t));
+        }
+    }
+}
+
+// Next capture frame event, its payload
+static const jw_capture_frame_t *wait_frame(uint8_t *msg) {
+    for (;;) {
+        size_t len = next_msg(msg);
+        const jw_msg_header_t *hdr = (const jw_msg_header_t*)msg;
+        if (hdr->type == JW_MSG_TYPE_EVT && hdr->cmd == JW_CMD_CAPTURE && len >= sizeof(jw_msg_header_t) + sizeof(jw_capture_frame_t)) {
+            const jw_capture_frame_t *f = (const jw_capture_frame_t*)(msg + sizeof(jw_msg_header_t));
+            if (len >= sizeof(jw_msg_header_t) + sizeof(*f) + f->count * sizeof(jw_capture_rect_t)) return f;
+        }
+    }
+}
+
+static int format_bpp(uint8_t format) {
+    return format == JW_PIXFMT_RGB565 || format == JW_PIXFMT_ARGB4444 ? 2 : 4;
+}
+
+static int write_ppm(const char *path, const uint8_t *pixels, int w, int h, int stride, uint8_t format) {
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    for (int y = 0; y < h; y++) {
+        const uint8_t *row = pixels + (size_t)y * stride;
+        for (int x = 0; x < w; x++) {
+            uint8_t rgb[3];
+            if (format == JW_PIXFMT_RGB565) {
+                uint16_t p;
+                memcpy(&p, row + x * 2, 2);
+                rgb[0] = (uint8_t)(((p >> 11) & 0x1F) * 255 / 31);
+                rgb[1] = (uint8_t)(((p >> 5) & 0x3F) * 255 / 63);
+                rgb[2] = (uint8_t)((p & 0x1F) * 255 / 31);
+            } else if (format == JW_PIXFMT_ARGB4444) {
+                uint16_t p;
+                memcpy(&p, row + x * 2, 2);
+                rgb[0] = (uint8_t)(((p >> 8) & 0xF) * 17);
+                rgb[1] = (uint8_t)(((p >> 4) & 0xF) * 17);
+                rgb[2] = (uint8_t)((p & 0xF) * 17);
+            } else {
+                uint32_t p;
+                memcpy(&p, row + x * 4, 4);
+                rgb[0] = (uint8_t)(p >> 16);
+                rgb[1] = (uint8_t)(p >> 8);
+                rgb[2] = (uint8_t)p;
+            }
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+    return fclose(f);
+}
+
+int main(int argc, char *argv[]) {
+    jw_payload_capture_t p = {0};
+    p.display_id = 1;
+    p.format = JW_PIXFMT_XRGB8888;
+    const char *out = NULL;
+    int frames = 0;
+    int slow_ms = 0;
+    int w = 0, h = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--display") == 0 && i + 1 < argc) {
+            p.display_id = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--region") == 0 && i + 1 < argc) {
+            int x, y;
+            if (sscanf(argv[++i], "%d,%d,%d,%d", &x, &y, &w, &h) != 4 || w <= 0 || h <= 0) {
+                fprintf(stderr, "--region takes X,Y,W,H\n");
+                return 1;
+            }
+            p.x = (int16_t)x;
+            p.y = (int16_t)y;
+            p.w = (uint16_t)w;
+            p.h = (uint16_t)h;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char *f = argv[++i];
+            if (strcmp(f, "argb8888") == 0) p.format = JW_PIXFMT_ARGB8888;
+            else if (strcmp(f, "xrgb8888") == 0) p.format = JW_PIXFMT_XRGB8888;
+            else if (strcmp(f, "rgb565") == 0) p.format = JW_PIXFMT_RGB565;
+            else if (strcmp(f, "argb4444") == 0) p.format = JW_PIXFMT_ARGB4444;
+            else {
+                fprintf(stderr, "--format takes argb8888, xrgb8888, rgb565 or argb4444\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out = argv[++i];
+        } else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--slow") == 0 && i + 1 < argc) {
+            slow_ms = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--display ID] [--region X,Y,W,H] [--format F] [--out FILE.ppm] [--stream N] [--slow MS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    g_sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, JW_MT_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(g_sock, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        perror("connect");
+        return 1;
+    }
+
+    // Without --region the whole display, its size comes with the stats
+    static uint8_t msg[JW_MSG_MAX_LEN];
+    if (p.w == 0) {
+        jw_payload_stats_t p_stats = {0};
+        const jw_payload_response_t *resp = wait_reply(send_cmd(JW_CMD_STATS, &p_stats, sizeof(p_stats), -1), msg, NULL);
+        const jw_stats_reply_t *reply = (const jw_stats_reply_t*)(resp + 1);
+        const jw_stats_output_t *o = (const jw_stats_output_t*)((const uint8_t*)(reply + 1) +
+                                     reply->client_count * sizeof(jw_stats_client_t));
+        for (int i = 0; i < reply->output_count; i++, o++) {
+            if (o->display_id != p.display_id) continue;
+            w = o->w;
+            h = o->h;
+        }
+        if (w == 0) {
+            fprintf(stderr, "No display %d\n", p.display_id);
+            return 1;
+        }
+    }
+
+    int stride = w * format_bpp(p.format);
+    size_t size = (size_t)stride * h;
+    int fd = shm_create_anon("capture", size);
+    if (fd < 0) {
+        perror("memfd");
+        return 1;
+    }
+    shm_seal(fd, true); // the core writes into it, but wants it unshrinkable
+    uint8_t *pixels = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (pixels == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    p.stride = (uint32_t)stride;
+    if (frames > 0) p.flags = JW_CAPTURE_F_STREAM;
+
+    uint64_t t0 = now_ns();
+    static uint8_t first[JW_MSG_MAX_LEN];
+    const jw_payload_response_t *resp = wait_reply(send_cmd(JW_CMD_CAPTURE, &p, sizeof(p), fd), msg, first);
+    close(fd);
+    if (resp->status != 0) {
+        fprintf(stderr, "Capture failed\n");
+        return 1;
+    }
+
+    if (frames == 0) {
+        printf("frame %d captured in %.2f ms\n", resp->data.new_id, (now_ns() - t0) / 1e6);
+    } else {
+        jw_payload_capture_t p_release = { p.display_id, JW_CAPTURE_F_RELEASE, 0, 0, 0, 0, 0, 0 };
+        for (int n = 0; n < frames; n++) {
+            const jw_capture_frame_t *f;
+            if (n == 0 && ((jw_msg_header_t*)first)->len) f = (const jw_capture_frame_t*)(first + sizeof(jw_msg_header_t));
+            else f = wait_frame(msg);
+            uint64_t px = 0;
+            const jw_capture_rect_t *r = (const jw_capture_rect_t*)(f + 1);
+            printf("frame %u: %u rects", f->seq, f->count);
+            for (int i = 0; i < f->count; i++) {
+                printf(" %d,%d %ux%u", r[i].x, r[i].y, r[i].w, r[i].h);
+                px += (uint64_t)r[i].w * r[i].h;
+            }
+            printf(", %llu px, %.2f ms after present\n", (unsigned long long)px, (now_ns() - f->timestamp) / 1e6);
+            fflush(stdout);
+            if (slow_ms > 0) usleep((useconds_t)slow_ms * 1000);
+            if (n + 1 < frames) wait_reply(send_cmd(JW_CMD_CAPTURE, &p_release, sizeof(p_release), -1), msg, NULL);
+        }
+        jw_payload_capture_t p_stop = { p.display_id, JW_CAPTURE_F_STOP, 0, 0, 0, 0, 0, 0 };
+        wait_reply(send_cmd(JW_CMD_CAPTURE, &p_stop, sizeof(p_stop), -1), msg, NULL);
+    }
+
+    if (out && write_ppm(out, pixels, w, h, stride, p.format) == 0) printf("Wrote %s\n", out);
+
+    munmap(pixels, size);
+    close(g_sock);
+    return 0;
+}
@@ -11,8 +11,10 @@
     -----------------------------------------------------------
 */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
@@ -20,16 +22,90 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/select.h>
+#include <sys/ioctl.h>
 #include <fcntl.h>
 #include <stdbool.h>
 #include <errno.h>
+#include <signal.h>
+#include <pthread.h>
 #include <SDL2/SDL.h>
 #include "protocol.h"
+#include "shm_helper.h"
+#include "jw_accel.h"
+#include "jw_resource.h"
+#include "jw_region.h"
+#include "jw_record.h"
+#include "jw_stats.h"
+#include "jw_uring.h"
+#include "jw_damage.h"
+#include "jw_mem.h"
 
 // #define JW_MT_SOCKET_PATH "/tmp/jw_mt_core.sock" // Moved to protocol.h 
 #define MAX_CLIENTS 10
+#define MAX_DRAW_OPS 16384 // lists past a message go through JW_CMD_BULK
+#define DEFAULT_RESOURCE_BUDGET_MB 32
+#define INPUT_HISTORY 32 // delivered events kept for input-to-photon
+#define DEFAULT_PREWARM 2
+#define MAX_PREWARM 8
+#define MAX_FRAME_REPLIES 32 // frame replies waiting for a present, per display
+
+// Layer handle, the state only painting needs. Geometry and visibility live
+// in the display's z array, see jw_layer_hot_t.
+typedef struct jw_layer {
+    uint32_t id;
+    int z;                   // index in jw_display_t.z
+    uint8_t content;         // JW_LAYER_CONTENT_*
+    uint8_t flags;           // JW_LAYER_F_*
+    uint32_t color_from;     // solid / gradient
+    uint32_t color_to;
+    uint32_t resource_id;    // resource content
+    uint32_t tint;           // colour for A8 resources
+    jw_region_t shown;       // scratch, valid while the display is composed
+} jw_layer_t;
+
+// What the visibility and damage passes read per layer, packed in paint order
+// (index 0 = bottom) so they stream through it instead of chasing handles.
+// Restacking moves entries and renumbers only the handles that moved.
+typedef struct jw_layer_hot {
+    jw_rect_t rect;
+    uint32_t id;
+    uint8_t opacity;
+    bool visible;
+    jw_layer_t *layer;
+} jw_layer_hot_t;
+
+// Reply to a frame message, sent once the frame is on screen
+typedef struct jw_frame_reply {
+    int slot;                // client slot, skipped if it reconnected since
+    uint32_t gen;
+    uint16_t msg_id;
+    uint64_t recv_ns;
+} jw_frame_reply_t;
+
+// JW_CMD_CAPTURE into a client's memory. The render thread copies from the
+// frame it just composed, the main loop announces it once presented and the
+// copy's fence has signalled.
+typedef struct jw_capture {
+    int client;              // socket, 0 = no capture
+    uint16_t msg_id;         // one-shot: replied to once written
+    bool stream;
+    jw_buffer_t buf;         // the client's memory, area sized
+    size_t map_size;
+    jw_rect_t area;          // display coordinates
+    jw_region_t pending;     // changed since the last frame written
+    jw_region_t written;     // what the unannounced frame covers
+    bool ready;              // written, not announced yet
+    bool copying;            // queued, the render thread waits without `lock`
+    bool held;               // the client has a frame it did not release
+    uint32_t seq;
+} jw_capture_t;
 
 // Simple structure to manage displays (SDL Windows)
+//
+// Each display composes on its own render thread at its own refresh rate.
+// The scene (layers, draw list, canvas, damage) and the frame hand-off below
+// are guarded by `lock`, which the render thread holds while composing; SDL
+// objects, input and photon tracking belong to the main loop.
 typedef struct jw_display {
     int id;
     SDL_Window *window;
@@ -39,11 +115,168 @@ typedef struct jw_display {
     char shm_name[64];
     int shm_fd;
     void *shm_ptr;
+    int canvas_w, canvas_h;  // may be smaller than the display, scaled at composition
+    jw_format_t canvas_format;
+    uint32_t canvas_layer;   // the bottom layer create_canvas() added, 0 = none
+
+    jw_buffer_t fb;          // composition target, uploaded to texture by damage
+    jw_buffer_t out;         // fb rotated to the panel, only with --rotate
+    jw_rect_t damage;        // area to recompose at next present
+    bool canvas_committed;   // committed without saying what changed, --auto-damage finds out
+    jw_tile_hashes_t canvas_tiles; // canvas as of the last --auto-damage commit
+    bool scanout;            // canvas goes to the texture directly, fb is stale
+
+    jw_layer_hot_t *z;       // layers bottom to top
+    int layer_count;
+    int layer_cap;
+
+    jw_draw_op_t *draw_ops;  // retained draw list, see JW_CMD_DRAW
+    int draw_count;
+    int draw_cap;
+
+    int owner;               // client socket that created it
+    int refresh_hz;
+    jw_output_counters_t stats;
+    uint64_t commit_ns;      // oldest frame message not composed yet, 0 = none
+    uint64_t last_present_ns;
+
+    jw_accelerator_t *accel; // per display, so outputs never queue behind each other
+    const jw_buffer_t **held; // resources pinned by the frame being composed
+    int held_count;
+    int held_cap;
+
+    pthread_t thread;
+    bool thread_running;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;     // frame wanted, frame taken, or stop
+    bool stop;
+    bool frame_wanted;       // scene changed by a frame message
+    bool frame_ready;        // composed, waiting for the main loop to present it
+    jw_rect_t ready_clip;    // area of ready_src to upload, empty = nothing changed
+    jw_buffer_t ready_src;
+    uint64_t ready_ns;
+    uint64_t ready_commit_ns;
+    uint32_t ready_photon;
+    jw_frame_reply_t replies[MAX_FRAME_REPLIES];
+    int reply_count;
+    int ready_replies;       // the first ones in `replies` belong to the ready frame
+
+    int input_listener;      // socket getting this display's input, 0 = none
+    jw_event_t inputs[INPUT_HISTORY];  // ring of delivered events
+    int input_next;
+    uint32_t photon_pending; // newest serial a frame reacts to, shown at the next present
+    uint32_t photon_done;    // events up to here are measured
+
+    jw_capture_t capture;    // under `lock`
+
     struct jw_display *next;
 } jw_display_t;
 
 jw_display_t *g_displays = NULL;
 int g_display_id_counter = 0;
+uint32_t g_layer_id_counter = 0;
+uint32_t g_input_serial = 0;
+jw_resource_cache_t g_resources;
+jw_rotation_t g_rotation = JW_ROTATE_0;
+jw_recorder_t *g_recorder = NULL;   // --record
+bool g_auto_damage = false;         // --auto-damage
+uint32_t g_window_flags = 0;
+uint32_t g_renderer_flags = 0;
+
+// Hidden window + renderer made while idle, so a new display does not stall
+// every client on the window system
+typedef struct jw_warm_output {
+    SDL_Window *window;
+    SDL_Renderer *renderer;
+} jw_warm_output_t;
+
+jw_warm_output_t g_warm[MAX_PREWARM];
+int g_warm_count = 0;
+int g_warm_target = DEFAULT_PREWARM;
+static volatile sig_atomic_t g_quit = 0;
+int g_wake_pipe[2] = { -1, -1 };    // render threads wake the main loop with a frame
+jw_uring_t *g_uring = NULL;         // --io-uring, select() otherwise
+
+// A message whose display was busy composing, retried before the client is read again
+typedef struct jw_parked_msg {
+    char buf[JW_MSG_MAX_LEN];
+    ssize_t len;             // 0 = nothing parked
+    int fd;
+    uint64_t recv_ns;
+} jw_parked_msg_t;
+
+jw_parked_msg_t g_parked[MAX_CLIENTS];
+uint32_t g_client_gen[MAX_CLIENTS];
+
+// Per connection slot, see JW_CMD_BULK_ATTACH
+typedef struct jw_bulk_region {
+    char *ptr;               // read-only mapping of the client's memory
+    size_t size;
+    char *copy;              // the command being handled, out of the client's reach
+    size_t copy_cap;
+} jw_bulk_region_t;
+
+jw_bulk_region_t g_bulk[MAX_CLIENTS];
+
+// Per connection slot, see JW_CMD_STATS
+typedef struct jw_client_stats {
+    jw_client_counters_t counters;
+    uint64_t rate_base;      // commits when the current second began
+    uint32_t commit_rate;
+    uint32_t interval_ms;    // periodic report, 0 = off
+    uint64_t next_report_ns;
+    uint32_t throttled;      // frames over budget
+} jw_client_stats_t;
+
+jw_client_stats_t g_client_stats[MAX_CLIENTS];
+
+// Per connection slot, see JW_CMD_SET_PRIORITY
+typedef struct jw_client_sched {
+    uint8_t priority;        // JW_PRIO_*
+    uint64_t used_ns;        // handling time in the current frame
+    bool throttled;          // out of budget, not read until the next frame
+    uint64_t due_ns;         // next vsync of its displays, for ordering
+} jw_client_sched_t;
+
+// Core time per frame before a client waits for the next one, 0 = unbounded
+static const uint64_t k_frame_budget_ns[JW_PRIO_COUNT] = {
+    [JW_PRIO_BACKGROUND]  = 2000000,
+    [JW_PRIO_NORMAL]      = 6000000,
+    [JW_PRIO_INTERACTIVE] = 0,
+};
+
+jw_client_sched_t g_sched[MAX_CLIENTS];
+
+// Per connection slot, see JW_CMD_SET_INTEGRITY
+typedef struct jw_client_wire {
+    int sd;                  // socket the slot had when the mode was set
+    uint8_t integrity;       // JW_INTEGRITY_*
+} jw_client_wire_t;
+
+jw_client_wire_t g_wire[MAX_CLIENTS];
+uint64_t g_frame_start_ns = 0;
+uint64_t g_start_ns = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_quit = 1;
+}
+
+// As int, the two are different enums (-Wenum-compare)
+_Static_assert((int)JW_PIXFMT_ARGB8888 == (int)JW_FORMAT_ARGB8888 && (int)JW_PIXFMT_XRGB8888 == (int)JW_FORMAT_XRGB8888 &&
+               (int)JW_PIXFMT_RGB565 == (int)JW_FORMAT_RGB565 && (int)JW_PIXFMT_ARGB4444 == (int)JW_FORMAT_ARGB4444 &&
+               (int)JW_PIXFMT_A8 == (int)JW_FORMAT_A8, "Wire pixel formats must match jw_format_t");
+
+// Texture format for a scan-out format, 0 if it cannot be shown
+static uint32_t sdl_pixel_format(jw_format_t format) {
+    switch (format) {
+        case JW_FORMAT_ARGB8888: return SDL_PIXELFORMAT_ARGB8888;
+        case JW_FORMAT_XRGB8888: return SDL_PIXELFORMAT_RGB888;
+        case JW_FORMAT_RGB565:   return SDL_PIXELFORMAT_RGB565;
+        case JW_FORMAT_ARGB4444: return SDL_PIXELFORMAT_ARGB4444;
+        default:                 return 0;
+    }
+}
 
 // Find display by ID
 jw_display_t* find_display(int id) {
@@ -55,13 +288,1369 @@ jw_display_t* find_display(int id) {
     return NULL;
 }
 
+// How messages to and from sd are checked
+static uint8_t client_integrity(int sd) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (g_wire[i].sd == sd) return g_wire[i].integrity;
+    }
+    return JW_INTEGRITY_CHECKSUM;
+}
+
+// Every message to a client goes through here, see send_msg_fd(). Seals it
+// for the connection's integrity mode, buf needs JW_CRC_LEN bytes to spare.
+static void core_send(int sd, uint8_t *buf, size_t len, int fd) {
+    len = jw_msg_seal(buf, len, client_integrity(sd));
+    if (g_uring) jw_uring_send(g_uring, sd, buf, len, fd);
+    else send_msg_fd(sd, buf, len, fd);
+}
+
+// fd (if not -1) rides along with the response
+static void send_response_fd(int sd, uint16_t msg_id, const jw_payload_response_t *resp_data, int fd) {
+    jw_msg_header_t resp_hdr = {0};
+    resp_hdr.type = JW_MSG_TYPE_RESP;
+    resp_hdr.cmd = JW_CMD_RESPONSE;
+    resp_hdr.msg_id = msg_id;
+    resp_hdr.len = sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t);
+
+    uint8_t resp_buf[256];
+    memcpy(resp_buf, &resp_hdr, sizeof(jw_msg_header_t));
+    memcpy(resp_buf + sizeof(jw_msg_header_t), resp_data, sizeof(jw_payload_response_t));
+    core_send(sd, resp_buf, resp_hdr.len, fd);
+}
+
+static void send_response(int sd, uint16_t msg_id, const jw_payload_response_t *resp_data) {
+    send_response_fd(sd, msg_id, resp_data, -1);
+}
+
+static jw_buffer_t display_canvas(jw_display_t *disp) {
+    jw_buffer_t canvas = { disp->canvas_w, disp->canvas_h, disp->canvas_w * jw_format_bpp(disp->canvas_format),
+                           disp->shm_ptr, disp->canvas_format };
+    return canvas;
+}
+
+static void damage_display(jw_display_t *disp, const jw_rect_t *rect) {
+    jw_rect_t screen = { 0, 0, disp->w, disp->h };
+    jw_rect_t clipped;
+    if (jw_rect_intersect(rect, &screen, &clipped)) {
+        jw_rect_union(&disp->damage, &clipped);
+    }
+}
+
+// Area of the canvas (canvas pixels) as it lands on screen through its layers
+static void damage_canvas(jw_display_t *disp, const jw_rect_t *area) {
+    if (disp->canvas_w <= 0 || disp->canvas_h <= 0) return;
+    for (int k = 0; k < disp->layer_count; k++) {
+        const jw_layer_hot_t *l = &disp->z[k];
+        if (!l->visible || l->layer->content != JW_LAYER_CONTENT_CANVAS) continue;
+        // Scaled: round outwards, plus a pixel the filter reads across
+        int64_t x0 = (int64_t)area->x * l->rect.w / disp->canvas_w - 1;
+        int64_t y0 = (int64_t)area->y * l->rect.h / disp->canvas_h - 1;
+        int64_t x1 = ((int64_t)(area->x + area->w) * l->rect.w + disp->canvas_w - 1) / disp->canvas_w + 1;
+        int64_t y1 = ((int64_t)(area->y + area->h) * l->rect.h + disp->canvas_h - 1) / disp->canvas_h + 1;
+        jw_rect_t r = { l->rect.x + (int)x0, l->rect.y + (int)y0, (int)(x1 - x0), (int)(y1 - y0) };
+        jw_rect_t c;
+        if (jw_rect_intersect(&r, &l->rect, &c)) damage_display(disp, &c);
+    }
+}
+
+static jw_rect_t draw_ops_bounds(const jw_draw_op_t *ops, int count) {
+    jw_rect_t bounds = {0};
+    for (int i = 0; i < count; i++) {
+        jw_rect_t r = { ops[i].x, ops[i].y, ops[i].w, ops[i].h };
+        jw_rect_union(&bounds, &r);
+    }
+    return bounds;
+}
+
+// Replace (or append to) the retained draw list, damaging what changes on screen
+static int set_draw_list(jw_display_t *disp, const jw_draw_op_t *ops, int count, bool append) {
+    if (!append) {
+        jw_rect_t old = draw_ops_bounds(disp->draw_ops, disp->draw_count);
+        damage_display(disp, &old);
+        disp->draw_count = 0;
+    }
+
+    if (disp->draw_count + count > MAX_DRAW_OPS) return -1;
+    if (disp->draw_count + count > disp->draw_cap) {
+        int cap = disp->draw_cap ? disp->draw_cap : 16;
+        while (cap < disp->draw_count + count) cap *= 2;
+        jw_draw_op_t *grown = (jw_draw_op_t*)realloc(disp->draw_ops, cap * sizeof(jw_draw_op_t));
+        if (!grown) return -1;
+        disp->draw_ops = grown;
+        disp->draw_cap = cap;
+    }
+
+    memcpy(disp->draw_ops + disp->draw_count, ops, count * sizeof(jw_draw_op_t));
+    disp->draw_count += count;
+
+    jw_rect_t added = draw_ops_bounds(ops, count);
+    damage_display(disp, &added);
+    return 0;
+}
+
+// Resident pixels for the frame being composed, pinned until release_held()
+static const jw_buffer_t *hold_resource(jw_display_t *disp, uint32_t id) {
+    const jw_buffer_t *res = jw_resource_acquire(&g_resources, id);
+    if (!res) return NULL;
+    if (disp->held_count == disp->held_cap) {
+        int cap = disp->held_cap ? disp->held_cap * 2 : 16;
+        const jw_buffer_t **grown = (const jw_buffer_t**)realloc(disp->held, cap * sizeof(*grown));
+        if (!grown) {
+            jw_resource_release(&g_resources, res);
+            return NULL;
+        }
+        disp->held = grown;
+        disp->held_cap = cap;
+    }
+    disp->held[disp->held_count++] = res;
+    return res;
+}
+
+static void release_held(jw_display_t *disp) {
+    for (int i = 0; i < disp->held_count; i++) jw_resource_release(&g_resources, disp->held[i]);
+    disp->held_count = 0;
+}
+
+// Put src (origin sx,sy) at `r`, touching only `clip` (already inside r)
+static void composite_buffer(jw_display_t *disp, const jw_buffer_t *src, int sx, int sy,
+                             const jw_rect_t *r, const jw_rect_t *clip, jw_blend_mode_t mode, uint8_t alpha) {
+    jw_rect_t src_bounds = { 0, 0, src->w, src->h };
+    jw_rect_t sr = { sx + (clip->x - r->x), sy + (clip->y - r->y), clip->w, clip->h };
+    jw_rect_t sc;
+    if (!jw_rect_intersect(&sr, &src_bounds, &sc)) return;
+    jw_rect_t dr = { clip->x + (sc.x - sr.x), clip->y + (sc.y - sr.y), sc.w, sc.h };
+    disp->accel->ops->blend(disp->accel, src, &sc, &disp->fb, &dr, mode, alpha);
+}
+
+// Same placement as composite_buffer, for A8 coverage tinted with `color`
+static void composite_mask(jw_display_t *disp, const jw_buffer_t *mask, int sx, int sy,
+                           const jw_rect_t *r, const jw_rect_t *clip, uint32_t color, uint8_t alpha) {
+    jw_rect_t src_bounds = { 0, 0, mask->w, mask->h };
+    jw_rect_t sr = { sx + (clip->x - r->x), sy + (clip->y - r->y), clip->w, clip->h };
+    jw_rect_t sc;
+    if (!jw_rect_intersect(&sr, &src_bounds, &sc)) return;
+    jw_rect_t dr = { clip->x + (sc.x - sr.x), clip->y + (sc.y - sr.y), sc.w, sc.h };
+    disp->accel->ops->blend_mask(disp->accel, mask, &sc, &disp->fb, &dr, color, alpha);
+}
+
+// Stretch the whole of src over `r`, touching only `clip`
+static void composite_scaled(jw_display_t *disp, const jw_buffer_t *src, const jw_rect_t *r,
+                             const jw_rect_t *clip, jw_filter_t filter, jw_blend_mode_t mode, uint8_t alpha) {
+    if (src->w == r->w && src->h == r->h) {
+        composite_buffer(disp, src, 0, 0, r, clip, mode, alpha);
+        return;
+    }
+    jw_rect_t src_rect = { 0, 0, src->w, src->h };
+    disp->accel->ops->scale(disp->accel, src, &src_rect, &disp->fb, r, clip, filter, mode, alpha);
+}
+
+static void render_draw_op(jw_display_t *disp, const jw_draw_op_t *op, const jw_rect_t *clip) {
+    jw_rect_t r = { op->x, op->y, op->w, op->h };
+    jw_rect_t c;
+    if (!jw_rect_intersect(&r, clip, &c)) return;
+
+    switch (op->op) {
+        case JW_DRAW_FILL_RECT:
+            disp->accel->ops->fill_rect(disp->accel, &disp->fb, &c, op->u.color.from);
+            break;
+        case JW_DRAW_BLEND_RECT:
+            disp->accel->ops->blend_rect(disp->accel, &disp->fb, &c, op->u.color.from, op->alpha);
+            break;
+        case JW_DRAW_GRADIENT: {
+            jw_gradient_t grad = { r, op->u.color.from, op->u.color.to, (op->flags & JW_DRAW_F_VERTICAL) != 0, op->alpha };
+            disp->accel->ops->gradient(disp->accel, &disp->fb, &c, &grad);
+            break;
+        }
+        case JW_DRAW_BLIT: {
+            jw_buffer_t src;
+            if (op->u.blit.resource_id == 0) {
+                if (!disp->shm_ptr) break;
+                src = display_canvas(disp);
+            } else {
+                const jw_buffer_t *res = hold_resource(disp, op->u.blit.resource_id);
+                if (!res) break;
+                src = *res;
+            }
+            composite_buffer(disp, &src, op->u.blit.sx, op->u.blit.sy, &r, &c, JW_BLEND_SRC_OVER, op->alpha);
+            break;
+        }
+        case JW_DRAW_MASK: {
+            const jw_buffer_t *mask = hold_resource(disp, op->u.mask.resource_id);
+            if (!mask || mask->format != JW_FORMAT_A8) break;
+            composite_mask(disp, mask, op->u.mask.sx, op->u.mask.sy, &r, &c, op->u.mask.color, op->alpha);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static jw_layer_t *find_layer(jw_display_t *disp, uint32_t id) {
+    for (int k = 0; k < disp->layer_count; k++) {
+        if (disp->z[k].id == id) return disp->z[k].layer;
+    }
+    return NULL;
+}
+
+static jw_layer_hot_t *layer_hot(jw_display_t *disp, const jw_layer_t *layer) {
+    return &disp->z[layer->z];
+}
+
+static void damage_layer(jw_display_t *disp, const jw_layer_t *layer) {
+    const jw_layer_hot_t *h = layer_hot(disp, layer);
+    if (h->visible) damage_display(disp, &h->rect);
+}
+
+static void apply_layer_desc(jw_display_t *disp, jw_layer_t *layer, uint32_t mask, const jw_layer_desc_t *desc) {
+    jw_layer_hot_t *h = layer_hot(disp, layer);
+    if (mask & JW_LAYER_SET_GEOMETRY) {
+        jw_rect_t r = { desc->x, desc->y, desc->w, desc->h };
+        h->rect = r;
+    }
+    if (mask & JW_LAYER_SET_OPACITY) h->opacity = desc->opacity;
+    if (mask & JW_LAYER_SET_VISIBLE) h->visible = desc->visible != 0;
+    if (mask & JW_LAYER_SET_CONTENT) {
+        layer->content = desc->content;
+        layer->flags = desc->flags;
+        if (desc->content == JW_LAYER_CONTENT_RESOURCE) {
+            layer->resource_id = desc->u.resource.id;
+            layer->tint = desc->u.resource.tint;
+        } else {
+            layer->color_from = desc->u.color.from;
+            layer->color_to = desc->u.color.to;
+        }
+    }
+}
+
+// Handles from index `from` up moved, tell them where they are now
+static void renumber_layers(jw_display_t *disp, int from, int to) {
+    for (int k = from; k < to; k++) disp->z[k].layer->z = k;
+}
+
+// Insert at z index `at`, moving the layers from there up by one
+static int link_layer(jw_display_t *disp, const jw_layer_hot_t *entry, int at) {
+    if (disp->layer_count == disp->layer_cap) {
+        int cap = disp->layer_cap ? disp->layer_cap * 2 : 8;
+        jw_layer_hot_t *grown = (jw_layer_hot_t*)realloc(disp->z, cap * sizeof(jw_layer_hot_t));
+        if (!grown) return -1;
+        disp->z = grown;
+        disp->layer_cap = cap;
+    }
+    memmove(&disp->z[at + 1], &disp->z[at], (disp->layer_count - at) * sizeof(jw_layer_hot_t));
+    disp->z[at] = *entry;
+    disp->layer_count++;
+    renumber_layers(disp, at, disp->layer_count);
+    return 0;
+}
+
+// Take out of the z array, the entry is returned for relinking
+static jw_layer_hot_t unlink_layer(jw_display_t *disp, jw_layer_t *layer) {
+    int at = layer->z;
+    jw_layer_hot_t entry = disp->z[at];
+    memmove(&disp->z[at], &disp->z[at + 1], (disp->layer_count - at - 1) * sizeof(jw_layer_hot_t));
+    disp->layer_count--;
+    renumber_layers(disp, at, disp->layer_count);
+    layer->z = -1;
+    return entry;
+}
+
+// New layers go on top, unless `bottom` is set
+static jw_layer_t *create_layer(jw_display_t *disp, const jw_layer_desc_t *desc, bool bottom) {
+    jw_layer_t *layer = (jw_layer_t*)calloc(1, sizeof(jw_layer_t));
+    if (!layer) return NULL;
+    jw_layer_hot_t entry = {0};
+    entry.id = ++g_layer_id_counter;
+    entry.layer = layer;
+    layer->id = entry.id;
+    if (link_layer(disp, &entry, bottom ? 0 : disp->layer_count) != 0) {
+        free(layer);
+        return NULL;
+    }
+    apply_layer_desc(disp, layer, JW_LAYER_SET_GEOMETRY | JW_LAYER_SET_OPACITY | JW_LAYER_SET_VISIBLE | JW_LAYER_SET_CONTENT, desc);
+
+    damage_layer(disp, layer);
+    return layer;
+}
+
+static void destroy_layer(jw_display_t *disp, jw_layer_t *layer) {
+    damage_layer(disp, layer);
+    unlink_layer(disp, layer);
+    free(layer);
+}
+
+// Check every record first so that a transaction applies whole or not at all.
+// Returns -1 on success, else the index of the first bad record.
+static int validate_transaction(jw_display_t *disp, const jw_txn_record_t *recs, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!find_layer(disp, recs[i].layer_id)) return i;
+        if (recs[i].mask & JW_LAYER_SET_ORDER) {
+            if (recs[i].above == recs[i].layer_id) return i;
+            if (recs[i].above != 0 && !find_layer(disp, recs[i].above)) return i;
+        }
+    }
+    return -1;
+}
+
+static void apply_transaction(jw_display_t *disp, const jw_txn_record_t *recs, int count) {
+    for (int i = 0; i < count; i++) {
+        jw_layer_t *layer = find_layer(disp, recs[i].layer_id);
+        damage_layer(disp, layer);
+        apply_layer_desc(disp, layer, recs[i].mask, &recs[i].desc);
+        if (recs[i].mask & JW_LAYER_SET_ORDER) {
+            // Same size after the unlink, the link cannot fail
+            jw_layer_hot_t entry = unlink_layer(disp, layer);
+            link_layer(disp, &entry, recs[i].above ? find_layer(disp, recs[i].above)->z + 1 : 0);
+        }
+        damage_layer(disp, layer);
+    }
+}
+
+static jw_filter_t layer_filter(const jw_layer_t *layer) {
+    return (layer->flags & JW_LAYER_F_NEAREST) ? JW_FILTER_NEAREST : JW_FILTER_BILINEAR;
+}
+
+static void render_layer(jw_display_t *disp, const jw_layer_hot_t *h, const jw_rect_t *clip) {
+    const jw_layer_t *layer = h->layer;
+    jw_rect_t c;
+    if (!h->visible || h->opacity == 0) return;
+    if (!jw_rect_intersect(&h->rect, clip, &c)) return;
+
+    switch (layer->content) {
+        case JW_LAYER_CONTENT_CANVAS: {
+            if (!disp->shm_ptr) break;
+            jw_buffer_t canvas = display_canvas(disp);
+            // ARGB8888 canvas alpha is not meaningful to legacy clients, copy unless faded
+            bool copy = h->opacity == 255 && (jw_format_opaque(canvas.format) || canvas.format == JW_FORMAT_ARGB8888);
+            composite_scaled(disp, &canvas, &h->rect, &c, layer_filter(layer),
+                             copy ? JW_BLEND_NONE : JW_BLEND_SRC_OVER, h->opacity);
+            break;
+        }
+        case JW_LAYER_CONTENT_SOLID:
+            disp->accel->ops->blend_rect(disp->accel, &disp->fb, &c, layer->color_from, h->opacity);
+            break;
+        case JW_LAYER_CONTENT_GRADIENT: {
+            jw_gradient_t grad = { h->rect, layer->color_from, layer->color_to,
+                                   (layer->flags & JW_LAYER_F_VERTICAL) != 0, h->opacity };
+            disp->accel->ops->gradient(disp->accel, &disp->fb, &c, &grad);
+            break;
+        }
+        case JW_LAYER_CONTENT_RESOURCE: {
+            const jw_buffer_t *res = hold_resource(disp, layer->resource_id);
+            if (!res) break;
+            if (res->format == JW_FORMAT_A8) {
+                // Masks are tinted at their native size
+                composite_mask(disp, res, 0, 0, &h->rect, &c, layer->tint, h->opacity);
+                break;
+            }
+            composite_scaled(disp, res, &h->rect, &c, layer_filter(layer), JW_BLEND_SRC_OVER, h->opacity);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Whether the layer hides everything under its rect
+static bool layer_opaque(const jw_display_t *disp, const jw_layer_hot_t *h) {
+    const jw_layer_t *layer = h->layer;
+    if (!h->visible || h->opacity != 255) return false;
+    if (layer->flags & JW_LAYER_F_OPAQUE) return true;
+
+    switch (layer->content) {
+        case JW_LAYER_CONTENT_CANVAS:
+            // Drawn as a copy, see render_layer()
+            return disp->shm_ptr && (jw_format_opaque(disp->canvas_format) || disp->canvas_format == JW_FORMAT_ARGB8888);
+        case JW_LAYER_CONTENT_SOLID:
+            return (layer->color_from >> 24) == 0xFF;
+        case JW_LAYER_CONTENT_GRADIENT:
+            return (layer->color_from >> 24) == 0xFF && (layer->color_to >> 24) == 0xFF;
+        case JW_LAYER_CONTENT_RESOURCE: {
+            // Must also fill the rect: A8 masks are drawn at their native size.
+            // Only the format matters, an evicted resource stays evicted.
+            int format = jw_resource_format(&g_resources, layer->resource_id);
+            return format >= 0 && jw_format_opaque((jw_format_t)format);
+        }
+        default:
+            return false;
+    }
+}
+
+// Paint the layers bottom-up, each only where nothing opaque lies above it
+static void compose_layers(jw_display_t *disp, const jw_rect_t *clip) {
+    jw_region_t covered = { 0 };
+    for (int k = disp->layer_count - 1; k >= 0; k--) {
+        const jw_layer_hot_t *h = &disp->z[k];
+        jw_rect_t c;
+        if (!h->visible || h->opacity == 0 || !jw_rect_intersect(&h->rect, clip, &c)) {
+            h->layer->shown.count = 0;
+            continue;
+        }
+        jw_region_t *shown = &h->layer->shown;
+        jw_region_visible(shown, &c, &covered);
+        if (!jw_region_empty(shown) && layer_opaque(disp, h)) jw_region_add(&covered, &c);
+    }
+
+    // Background only where no opaque layer lands
+    jw_region_t bare;
+    jw_region_visible(&bare, clip, &covered);
+    for (int i = 0; i < bare.count; i++) {
+        disp->accel->ops->fill_rect(disp->accel, &disp->fb, &bare.rects[i], 0xFF000000);
+    }
+
+    for (int k = 0; k < disp->layer_count; k++) {
+        const jw_layer_hot_t *h = &disp->z[k];
+        for (int i = 0; i < h->layer->shown.count; i++) {
+            render_layer(disp, h, &h->layer->shown.rects[i]);
+        }
+    }
+}
+
+// The topmost layer is an opaque full-screen canvas in the output format:
+// nothing else can show, so the canvas is scanned out as is
+static bool canvas_scanout(jw_display_t *disp) {
+    if (disp->draw_count != 0 || !disp->shm_ptr) return false;
+    if (disp->canvas_w != disp->w || disp->canvas_h != disp->h || disp->canvas_format != disp->fb.format) return false;
+
+    int k = disp->layer_count - 1;
+    while (k >= 0 && (!disp->z[k].visible || disp->z[k].opacity == 0)) k--;
+    if (k < 0) return false;
+
+    const jw_layer_hot_t *l = &disp->z[k];
+    return l->layer->content == JW_LAYER_CONTENT_CANVAS && layer_opaque(disp, l) &&
+           l->rect.x == 0 && l->rect.y == 0 && l->rect.w == disp->w && l->rect.h == disp->h;
+}
+
+static void capture_end(jw_display_t *disp) {
+    jw_capture_t *cap = &disp->capture;
+    if (cap->copying) {
+        cap->client = 0; // unmapped by the render thread once the copy is done
+        return;
+    }
+    if (cap->buf.pixels) munmap(cap->buf.pixels, cap->map_size);
+    memset(cap, 0, sizeof(*cap));
+}
+
+// Map the client's memory and ask for a frame that writes the whole area
+static int capture_start(jw_display_t *disp, int sd, uint16_t msg_id, const jw_payload_capture_t *p, int fd) {
+    jw_capture_t *cap = &disp->capture;
+    if (cap->client || cap->copying) return -1; // a stream is stopped first
+    if (fd < 0 || p->format >= JW_FORMAT_COUNT || p->format == JW_FORMAT_A8) return -1;
+
+    jw_rect_t screen = { 0, 0, disp->w, disp->h };
+    jw_rect_t want = { p->x, p->y, p->w, p->h };
+    jw_rect_t area;
+    if (p->w == 0) want = screen;
+    if (!jw_rect_intersect(&want, &screen, &area) || memcmp(&area, &want, sizeof(area)) != 0) return -1;
+    int min_stride = area.w * jw_format_bpp((jw_format_t)p->format);
+    int stride = p->stride ? (int)p->stride : min_stride;
+    size_t size = (size_t)stride * area.h;
+    struct stat st;
+    if (stride < min_stride || fstat(fd, &st) != 0 || st.st_size < (off_t)size) return -1;
+#ifdef F_GET_SEALS
+    // Shrunk under the render thread's copy it would fault
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals == -1 || !(seals & F_SEAL_SHRINK)) {
+        fprintf(stderr, "capture fd not sealed against shrinking\n");
+        return -1;
+    }
+#endif
+    void *ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) return -1;
+
+    cap->client = sd;
+    cap->msg_id = msg_id;
+    cap->stream = (p->flags & JW_CAPTURE_F_STREAM) != 0;
+    cap->buf = (jw_buffer_t){ area.w, area.h, stride, ptr, (jw_format_t)p->format };
+    cap->map_size = size;
+    cap->area = area;
+    jw_region_init(&cap->pending, &area);
+    pthread_cond_signal(&disp->wake); // copied by the render thread, see capture_due()
+    return 0;
+}
+
+// Area recomposed this frame, display coordinates. Unlike culling, nothing
+// may be dropped: past JW_REGION_MAX_RECTS it all becomes one bounding rect.
+static void capture_damage(jw_display_t *disp, const jw_rect_t *clip) {
+    jw_capture_t *cap = &disp->capture;
+    jw_rect_t r;
+    if (!cap->client || !jw_rect_intersect(clip, &cap->area, &r)) return;
+    jw_region_t extra;
+    jw_region_visible(&extra, &r, &cap->pending);
+    if (cap->pending.count + extra.count <= JW_REGION_MAX_RECTS) {
+        jw_region_add(&cap->pending, &r);
+        return;
+    }
+    for (int i = 0; i < cap->pending.count; i++) jw_rect_union(&r, &cap->pending.rects[i]);
+    jw_region_init(&cap->pending, &r);
+}
+
+// Changes the client can take: it released the last frame and that was announced
+static bool capture_due(const jw_display_t *disp) {
+    const jw_capture_t *cap = &disp->capture;
+    return cap->client && !cap->held && !cap->ready && !jw_region_empty(&cap->pending);
+}
+
+// Queue the copy of what changed into the client's memory, unless it still
+// reads the last frame. Only once the frame's fence has signalled: the soft
+// accelerator bands a blit by destination rows, which are not the fb rows
+// it reads, so it may not follow the composition in the same queue.
+static bool capture_frame(jw_display_t *disp) {
+    jw_capture_t *cap = &disp->capture;
+    if (!capture_due(disp)) return false;
+    jw_buffer_t src = disp->scanout ? display_canvas(disp) : disp->fb;
+    for (int i = 0; i < cap->pending.count; i++) {
+        const jw_rect_t *r = &cap->pending.rects[i];
+        jw_rect_t dr = { r->x - cap->area.x, r->y - cap->area.y, r->w, r->h };
+        disp->accel->ops->blit(disp->accel, &src, r, &cap->buf, &dr);
+    }
+    cap->written = cap->pending;
+    cap->pending.count = 0;
+    cap->held = cap->stream;
+    cap->seq++;
+    return true;
+}
+
+// Copy with a fence of its own. The lock is let go while the accelerator
+// works, so the main loop is not held up; capture_end() leaves the unmap to
+// us meanwhile.
+static void capture_copy(jw_display_t *disp) {
+    jw_capture_t *cap = &disp->capture;
+    if (!capture_frame(disp)) return;
+    jw_fence_t *done = disp->accel->ops->fence(disp->accel);
+    cap->copying = true;
+    pthread_mutex_unlock(&disp->lock);
+    if (!done || disp->accel->ops->fence_wait(disp->accel, done, -1) != 0) disp->accel->ops->sync(disp->accel);
+    disp->accel->ops->fence_release(disp->accel, done);
+    pthread_mutex_lock(&disp->lock);
+    cap->copying = false;
+    if (!cap->client) capture_end(disp); // stopped meanwhile
+    else __atomic_store_n(&cap->ready, true, __ATOMIC_RELEASE);
+}
+
+// A written frame to announce, into *out. With disp->lock held.
+static bool capture_take(jw_display_t *disp, jw_capture_t *out) {
+    if (!disp->capture.ready) return false;
+    *out = disp->capture;
+    disp->capture.ready = false;
+    if (!out->stream) capture_end(disp); // one-shot, written in full: the memory goes back
+    return true;
+}
+
+// Tell the client a captured frame is in its memory, on the main thread
+static void capture_announce(const jw_capture_t *cap, int display_id, uint64_t timestamp) {
+    if (!cap->stream) {
+        jw_payload_response_t resp_data = {0};
+        resp_data.data.new_id = (int)cap->seq;
+        send_response(cap->client, cap->msg_id, &resp_data);
+        return;
+    }
+    uint8_t buf[sizeof(jw_msg_header_t) + sizeof(jw_capture_frame_t) + JW_REGION_MAX_RECTS * sizeof(jw_capture_rect_t) + JW_CRC_LEN];
+    jw_capture_frame_t f = {0};
+    f.display_id = display_id;
+    f.seq = cap->seq;
+    f.timestamp = timestamp;
+    f.count = (uint8_t)cap->written.count;
+    size_t len = sizeof(jw_msg_header_t);
+    memcpy(buf + len, &f, sizeof(f));
+    len += sizeof(f);
+    for (int i = 0; i < cap->written.count; i++) {
+        const jw_rect_t *r = &cap->written.rects[i];
+        jw_capture_rect_t cr = { (int16_t)(r->x - cap->area.x), (int16_t)(r->y - cap->area.y), (uint16_t)r->w, (uint16_t)r->h };
+        memcpy(buf + len, &cr, sizeof(cr));
+        len += sizeof(cr);
+    }
+    jw_msg_header_t hdr = {0};
+    hdr.type = JW_MSG_TYPE_EVT;
+    hdr.cmd = JW_CMD_CAPTURE;
+    hdr.len = (uint16_t)len;
+    memcpy(buf, &hdr, sizeof(hdr));
+    core_send(cap->client, buf, len, -1);
+}
+
+// Recompose the damaged area for the main loop to show, on the render thread
+// with disp->lock held. Ops are queued and run on the accelerator while we go
+// on, see the fence.
+static void compose_frame(jw_display_t *disp) {
+    jw_rect_t screen = { 0, 0, disp->w, disp->h };
+    jw_rect_t clip;
+    uint64_t t0 = jw_stats_now_ns();
+
+    if (disp->canvas_committed) {
+        // Only the tiles that differ from the last commit
+        jw_buffer_t canvas = display_canvas(disp);
+        jw_rect_t changed;
+        if (jw_damage_detect(&disp->canvas_tiles, &canvas, &changed) > 0) damage_canvas(disp, &changed);
+        disp->canvas_committed = false;
+        jw_hist_add(&disp->stats.tile_hash, (uint32_t)((jw_stats_now_ns() - t0) / 1000));
+    }
+
+    bool scanout = canvas_scanout(disp);
+    if (scanout != disp->scanout) {
+        // fb was not kept up to date while scanning out, start over on either switch
+        printf("Display %d: %s\n", disp->id, scanout ? "direct scanout" : "back to composition");
+        disp->scanout = scanout;
+        damage_display(disp, &screen);
+    }
+
+    memset(&disp->ready_clip, 0, sizeof(disp->ready_clip));
+    if (jw_rect_intersect(&disp->damage, &screen, &clip)) {
+        jw_resource_frame_begin(&g_resources);
+        const jw_buffer_t *src = &disp->fb;
+        jw_buffer_t canvas = display_canvas(disp);
+
+        if (scanout) {
+            src = &canvas;
+        } else {
+            compose_layers(disp, &clip);
+            for (int i = 0; i < disp->draw_count; i++) {
+                render_draw_op(disp, &disp->draw_ops[i], &clip);
+            }
+        }
+        capture_damage(disp, &clip);
+
+        if (g_rotation != JW_ROTATE_0) {
+            // Portrait panels: turn the damaged area into panel orientation
+            disp->accel->ops->rotate(disp->accel, src, &clip, &disp->out, g_rotation);
+            clip = jw_rect_rotate(&clip, disp->w, disp->h, g_rotation);
+            src = &disp->out;
+        }
+
+        // The whole frame is queued, block only now that the pixels are needed
+        jw_fence_t *done = disp->accel->ops->fence(disp->accel);
+        if (!done || disp->accel->ops->fence_wait(disp->accel, done, -1) != 0) disp->accel->ops->sync(disp->accel);
+        disp->accel->ops->fence_release(disp->accel, done);
+        release_held(disp);
+
+        jw_stat_add(&disp->stats.dirty_px, (uint64_t)clip.w * clip.h);
+        disp->ready_clip = clip;
+        disp->ready_src = *src;
+    }
+    memset(&disp->damage, 0, sizeof(disp->damage));
+
+    // Everything asked for so far is in this frame
+    disp->ready_commit_ns = disp->commit_ns;
+    disp->commit_ns = 0;
+    disp->ready_photon = disp->photon_pending;
+    disp->ready_replies = disp->reply_count;
+    disp->frame_wanted = false;
+    __atomic_store_n(&disp->frame_ready, true, __ATOMIC_RELEASE);
+    disp->ready_ns = jw_stats_now_ns();
+    jw_hist_add(&disp->stats.composite, (uint32_t)((disp->ready_ns - t0) / 1000));
+}
+
+// Frames start at most once per refresh period of this output, so a slow
+// secondary panel paces only itself
+static void *render_thread(void *arg) {
+    jw_display_t *disp = (jw_display_t*)arg;
+    uint64_t period = 1000000000ull / disp->refresh_hz;
+    uint64_t next = 0; // earliest start of the next frame
+
+    pthread_mutex_lock(&disp->lock);
+    while (!disp->stop) {
+        uint64_t now = jw_stats_now_ns();
+        if (capture_due(disp)) {
+            // Content the capture has not got yet, of the frame just composed
+            // or one presented before: copied without composing, which would
+            // take the vsync slot of the next commit
+            capture_copy(disp);
+            char c = 0;
+            if (write(g_wake_pipe[1], &c, 1) < 0 && errno != EAGAIN) perror("wake");
+            continue;
+        }
+        if (!disp->frame_wanted || disp->frame_ready) {
+            pthread_cond_wait(&disp->wake, &disp->lock);
+            continue;
+        }
+        if (now < next) {
+#ifdef __linux__
+            uint64_t at = next; // the condition waits on CLOCK_MONOTONIC
+#else
+            struct timespec real;
+            clock_gettime(CLOCK_REALTIME, &real);
+            uint64_t at = (uint64_t)real.tv_sec * 1000000000ull + (uint64_t)real.tv_nsec + (next - now);
+#endif
+            struct timespec ts = { (time_t)(at / 1000000000ull), (long)(at % 1000000000ull) };
+            pthread_cond_timedwait(&disp->wake, &disp->lock, &ts);
+            continue;
+        }
+
+        compose_frame(disp);
+        uint64_t took = disp->ready_ns - now;
+        if (took > period) jw_stat_add(&disp->stats.missed_vsyncs, took / period);
+        next = now + period;
+
+        char c = 0;
+        if (write(g_wake_pipe[1], &c, 1) < 0 && errno != EAGAIN) perror("wake");
+    }
+    pthread_mutex_unlock(&disp->lock);
+    return NULL;
+}
+
+// Ask the render thread for a frame, with the reply to msg_id held back until
+// it is on screen. False if the reply has to go out now.
+static bool queue_frame(jw_display_t *disp, int slot, uint16_t msg_id, uint64_t recv_ns) {
+    disp->frame_wanted = true;
+    pthread_cond_signal(&disp->wake);
+    if (disp->reply_count == MAX_FRAME_REPLIES) return false;
+    jw_frame_reply_t *r = &disp->replies[disp->reply_count++];
+    r->slot = slot;
+    r->gen = g_client_gen[slot];
+    r->msg_id = msg_id;
+    r->recv_ns = recv_ns;
+    return true;
+}
+
+// Show a frame the render thread finished. SDL stays on the main thread.
+static void present_ready(jw_display_t *disp, const int *sockets) {
+    jw_frame_reply_t replies[MAX_FRAME_REPLIES];
+
+    pthread_mutex_lock(&disp->lock);
+    if (!disp->frame_ready) {
+        pthread_mutex_unlock(&disp->lock);
+        return;
+    }
+    uint64_t t1 = jw_stats_now_ns();
+    const jw_rect_t *clip = &disp->ready_clip;
+    if (!jw_rect_empty(clip)) {
+        SDL_Rect rect = { clip->x, clip->y, clip->w, clip->h };
+        SDL_UpdateTexture(disp->texture, &rect, jw_buffer_at(&disp->ready_src, clip->x, clip->y), disp->ready_src.stride);
+    }
+    int reply_count = disp->ready_replies;
+    memcpy(replies, disp->replies, reply_count * sizeof(jw_frame_reply_t));
+    memmove(disp->replies, disp->replies + reply_count, (disp->reply_count - reply_count) * sizeof(jw_frame_reply_t));
+    disp->reply_count -= reply_count;
+    disp->ready_replies = 0;
+    uint64_t ready_ns = disp->ready_ns;
+    uint64_t commit_ns = disp->ready_commit_ns;
+    uint32_t photon = disp->ready_photon;
+    jw_capture_t captured;
+    bool announce = capture_take(disp, &captured);
+    __atomic_store_n(&disp->frame_ready, false, __ATOMIC_RELEASE);
+    pthread_cond_signal(&disp->wake);
+    pthread_mutex_unlock(&disp->lock);
+
+    SDL_RenderClear(disp->renderer);
+    SDL_RenderCopy(disp->renderer, disp->texture, NULL, NULL);
+    SDL_RenderPresent(disp->renderer);
+
+    uint64_t t2 = jw_stats_now_ns();
+    disp->last_present_ns = t2;
+    jw_stat_add(&disp->stats.frames, 1);
+    jw_stat_add(&disp->stats.screen_px, (uint64_t)disp->w * disp->h);
+    jw_hist_add(&disp->stats.present, (uint32_t)((t2 - t1) / 1000));
+    // Sat composed for longer than a refresh: the main loop made it miss its vsync
+    if (t2 - ready_ns > 1000000000ull / disp->refresh_hz) jw_stat_add(&disp->stats.missed_vsyncs, 1);
+
+    if (commit_ns) jw_hist_add(&disp->stats.commit_to_present, (uint32_t)((t2 - commit_ns) / 1000));
+    // Every event up to the newest one reacted to has now reached the screen
+    for (int i = 0; i < INPUT_HISTORY; i++) {
+        const jw_event_t *ev = &disp->inputs[i];
+        if (ev->serial > disp->photon_done && ev->serial <= photon && t2 > ev->timestamp) {
+            jw_hist_add(&disp->stats.input_to_photon, (uint32_t)((t2 - ev->timestamp) / 1000));
+        }
+    }
+    if (photon > disp->photon_done) disp->photon_done = photon;
+    if (announce) capture_announce(&captured, disp->id, t2);
+
+    for (int i = 0; i < reply_count; i++) {
+        const jw_frame_reply_t *r = &replies[i];
+        if (sockets[r->slot] <= 0 || g_client_gen[r->slot] != r->gen) continue;
+        jw_payload_response_t resp_data = {0};
+        send_response(sockets[r->slot], r->msg_id, &resp_data);
+        jw_hist_add(&g_client_stats[r->slot].counters.latency, (uint32_t)((t2 - r->recv_ns) / 1000));
+    }
+}
+
+// A capture copied outside a frame, of what was presented last
+static void capture_poll(jw_display_t *disp) {
+    if (pthread_mutex_trylock(&disp->lock) != 0) return; // composing, next time round
+    jw_capture_t captured;
+    bool announce = !disp->frame_ready && capture_take(disp, &captured);
+    pthread_mutex_unlock(&disp->lock);
+    if (announce) capture_announce(&captured, disp->id, disp->last_present_ns);
+}
+
+// A frame message for disp arrived at recv_ns, reacting to input up to input_serial
+static void frame_requested(jw_display_t *disp, uint64_t recv_ns, uint32_t input_serial) {
+    if (!disp->commit_ns) disp->commit_ns = recv_ns;
+    if (input_serial > disp->photon_pending && input_serial <= g_input_serial) disp->photon_pending = input_serial;
+}
+
+// Stamp an event for disp and pass it to the display's listener
+static uint32_t deliver_input(jw_display_t *disp, const jw_event_t *event) {
+    jw_event_t *ev = &disp->inputs[disp->input_next];
+    disp->input_next = (disp->input_next + 1) % INPUT_HISTORY;
+    *ev = *event;
+    ev->serial = ++g_input_serial;
+    if (!ev->timestamp) ev->timestamp = jw_stats_now_ns();
+
+    if (disp->input_listener > 0) {
+        uint8_t buf[sizeof(jw_msg_header_t) + sizeof(jw_payload_input_t) + JW_CRC_LEN];
+        jw_msg_header_t hdr = {0};
+        hdr.type = JW_MSG_TYPE_EVT;
+        hdr.cmd = JW_CMD_INPUT;
+        hdr.len = sizeof(buf) - JW_CRC_LEN;
+        jw_payload_input_t p = {0};
+        p.display_id = disp->id;
+        p.event = *ev;
+        memcpy(buf, &hdr, sizeof(hdr));
+        memcpy(buf + sizeof(hdr), &p, sizeof(p));
+        core_send(disp->input_listener, buf, hdr.len, -1);
+    }
+    return ev->serial;
+}
+
+// Pointer input from a window, in panel coordinates
+static void sdl_pointer_input(uint32_t window_id, uint8_t type, uint8_t button, int x, int y) {
+    jw_display_t *disp = g_displays;
+    while (disp && SDL_GetWindowID(disp->window) != window_id) disp = disp->next;
+    if (!disp) return;
+
+    jw_rect_t at = { x, y, 1, 1 };
+    if (g_rotation != JW_ROTATE_0) {
+        bool sideways = g_rotation == JW_ROTATE_90 || g_rotation == JW_ROTATE_270;
+        at = jw_rect_rotate(&at, sideways ? disp->h : disp->w, sideways ? disp->w : disp->h,
+                            (jw_rotation_t)((4 - g_rotation) % 4));
+    }
+    jw_event_t ev = {0};
+    ev.type = type;
+    ev.button = button;
+    ev.x = (int16_t)at.x;
+    ev.y = (int16_t)at.y;
+    deliver_input(disp, &ev);
+}
+
+// Window and renderer for a display, pre-warmed ones first
+static bool open_output(jw_display_t *disp, const char *name, int panel_w, int panel_h) {
+    if (g_warm_count > 0) {
+        jw_warm_output_t *warm = &g_warm[--g_warm_count];
+        disp->window = warm->window;
+        disp->renderer = warm->renderer;
+        SDL_SetWindowTitle(disp->window, name);
+        SDL_SetWindowSize(disp->window, panel_w, panel_h);
+        if (!(g_window_flags & SDL_WINDOW_HIDDEN)) SDL_ShowWindow(disp->window);
+    } else {
+        disp->window = SDL_CreateWindow(name, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, panel_w, panel_h, g_window_flags);
+        if (disp->window) disp->renderer = SDL_CreateRenderer(disp->window, -1, g_renderer_flags);
+    }
+    return disp->window && disp->renderer;
+}
+
+// Make one hidden window + renderer ahead of need, called while the loop is idle
+static void prewarm_output(void) {
+    if (g_warm_count >= g_warm_target) return;
+    jw_warm_output_t *warm = &g_warm[g_warm_count];
+    warm->window = SDL_CreateWindow("", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 64, 64,
+                                    SDL_WINDOW_HIDDEN | (g_window_flags & SDL_WINDOW_ALLOW_HIGHDPI));
+    if (!warm->window) return;
+    warm->renderer = SDL_CreateRenderer(warm->window, -1, g_renderer_flags);
+    if (!warm->renderer) {
+        SDL_DestroyWindow(warm->window);
+        return;
+    }
+    g_warm_count++;
+}
+
+static void stop_render_thread(jw_display_t *disp) {
+    if (!disp->thread_running) return;
+    pthread_mutex_lock(&disp->lock);
+    disp->stop = true;
+    pthread_cond_signal(&disp->wake);
+    pthread_mutex_unlock(&disp->lock);
+    pthread_join(disp->thread, NULL);
+    disp->thread_running = false;
+}
+
+// Tear down a display, also one that failed halfway through creation
+static void destroy_display(jw_display_t *disp) {
+    stop_render_thread(disp);
+    capture_end(disp);
+    while (disp->layer_count) destroy_layer(disp, disp->z[disp->layer_count - 1].layer);
+    free(disp->z);
+    if (disp->shm_ptr) {
+        jw_mem_release(disp->shm_ptr);
+        munmap(disp->shm_ptr, (size_t)disp->canvas_w * disp->canvas_h * jw_format_bpp(disp->canvas_format));
+        close(disp->shm_fd);
+        shm_unlink(disp->shm_name);
+    }
+    jw_display_t **link = &g_displays;
+    while (*link && *link != disp) link = &(*link)->next;
+    if (*link) *link = disp->next;
+    if (disp->texture) SDL_DestroyTexture(disp->texture);
+    if (disp->renderer) SDL_DestroyRenderer(disp->renderer);
+    if (disp->window) SDL_DestroyWindow(disp->window);
+    jw_mem_free(disp->fb.pixels, (size_t)disp->fb.stride * disp->fb.h);
+    jw_mem_free(disp->out.pixels, (size_t)disp->out.stride * disp->out.h);
+    free(disp->draw_ops);
+    jw_damage_free(&disp->canvas_tiles);
+    release_held(disp);
+    free(disp->held);
+    if (disp->accel) jw_accel_soft_destroy(disp->accel);
+    pthread_cond_destroy(&disp->wake);
+    pthread_mutex_destroy(&disp->lock);
+    free(disp);
+}
+
+// Display with its output and render thread, NULL if the format cannot be shown
+// or SDL fails. refresh_hz 0 = whatever the output reports.
+static jw_display_t *create_display(const char *name, int w, int h, jw_format_t format, int refresh_hz, int owner) {
+    uint32_t sdl_format = format < JW_FORMAT_COUNT ? sdl_pixel_format(format) : 0;
+    if (!sdl_format || w <= 0 || h <= 0) return NULL;
+    int bpp = jw_format_bpp(format);
+
+    jw_display_t *disp = (jw_display_t*)calloc(1, sizeof(jw_display_t));
+    if (!disp) return NULL;
+    disp->w = w;
+    disp->h = h;
+    disp->owner = owner;
+    pthread_mutex_init(&disp->lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+#ifdef __linux__
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); // deadlines come from jw_stats_now_ns()
+#endif
+    pthread_cond_init(&disp->wake, &attr);
+    pthread_condattr_destroy(&attr);
+
+    // The client sees w x h, the panel may be mounted sideways
+    bool sideways = g_rotation == JW_ROTATE_90 || g_rotation == JW_ROTATE_270;
+    int panel_w = sideways ? h : w;
+    int panel_h = sideways ? w : h;
+    if (open_output(disp, name, panel_w, panel_h)) {
+        disp->texture = SDL_CreateTexture(disp->renderer, sdl_format, SDL_TEXTUREACCESS_STREAMING, panel_w, panel_h);
+        SDL_DisplayMode mode;
+        if (SDL_GetWindowDisplayMode(disp->window, &mode) == 0) disp->refresh_hz = mode.refresh_rate;
+    }
+    if (refresh_hz > 0) disp->refresh_hz = refresh_hz;
+    if (disp->refresh_hz <= 0) disp->refresh_hz = 60;
+
+    disp->fb.w = w;
+    disp->fb.h = h;
+    disp->fb.stride = w * bpp;
+    disp->fb.pixels = jw_mem_alloc((size_t)disp->fb.stride * h);
+    disp->fb.format = format;
+
+    disp->accel = jw_accel_soft_create();
+    bool ok = disp->texture && disp->fb.pixels && disp->accel;
+    if (g_rotation != JW_ROTATE_0) {
+        disp->out.w = panel_w;
+        disp->out.h = panel_h;
+        disp->out.stride = panel_w * bpp;
+        disp->out.pixels = jw_mem_alloc((size_t)disp->out.stride * panel_h);
+        disp->out.format = format;
+        ok = ok && disp->out.pixels;
+    }
+    if (!ok) {
+        printf("Failed to create SDL resources: %s\n", SDL_GetError());
+        destroy_display(disp);
+        return NULL;
+    }
+
+    jw_rect_t full = { 0, 0, w, h };
+    damage_display(disp, &full);
+    if (pthread_create(&disp->thread, NULL, render_thread, disp) != 0) {
+        printf("Failed to start the render thread\n");
+        destroy_display(disp);
+        return NULL;
+    }
+    disp->thread_running = true;
+    disp->id = ++g_display_id_counter;
+    disp->next = g_displays;
+    g_displays = disp;
+    return disp;
+}
+
+// Shared canvas for disp, shown as its bottom layer. w/h 0 = display size.
+// Replaces the canvas the display had, in the layer it had.
+static int create_canvas(jw_display_t *disp, int w, int h, jw_format_t format) {
+    if (format >= JW_FORMAT_COUNT || format == JW_FORMAT_A8) return -1;
+
+    // Canvases smaller than the display are scaled up at composition
+    int cw = (w && w <= disp->w) ? w : disp->w;
+    int ch = (h && h <= disp->h) ? h : disp->h;
+    size_t size = (size_t)cw * ch * jw_format_bpp(format);
+    snprintf(disp->shm_name, sizeof(disp->shm_name), "/jw_shm_%d", disp->id);
+    shm_unlink(disp->shm_name);
+    int fd = shm_open(disp->shm_name, O_CREAT | O_RDWR, 0666);
+    if (fd < 0) {
+        fprintf(stderr, "shm_open failed: %s\n", strerror(errno));
+        return -1;
+    }
+    if (ftruncate(fd, size) == -1) {
+        perror("ftruncate"); close(fd); shm_unlink(disp->shm_name);
+        return -1;
+    }
+    void *ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        perror("mmap failed"); close(fd); shm_unlink(disp->shm_name);
+        return -1;
+    }
+    jw_mem_prepare(ptr, size); // before the client draws the first frame into it
+    if (disp->shm_ptr) {
+        jw_mem_release(disp->shm_ptr);
+        munmap(disp->shm_ptr, (size_t)disp->canvas_w * disp->canvas_h * jw_format_bpp(disp->canvas_format));
+        close(disp->shm_fd);
+    }
+    disp->shm_fd = fd;
+    disp->shm_ptr = ptr;
+    disp->canvas_w = cw;
+    disp->canvas_h = ch;
+    disp->canvas_format = format;
+    jw_damage_reset(&disp->canvas_tiles);
+    jw_rect_t screen = { 0, 0, disp->w, disp->h };
+    damage_display(disp, &screen); // canvas layers all show the new one
+    if (find_layer(disp, disp->canvas_layer)) return 0;
+
+    // The canvas shows up as the bottom layer
+    jw_layer_desc_t desc = {0};
+    desc.w = disp->w;
+    desc.h = disp->h;
+    desc.opacity = 255;
+    desc.visible = 1;
+    desc.content = JW_LAYER_CONTENT_CANVAS;
+    jw_layer_t *layer = create_layer(disp, &desc, true);
+    if (!layer) return -1;
+    disp->canvas_layer = layer->id;
+    return 0;
+}
+
+// Capture a valid message for jw_mt_replay, with the canvas a COMMIT shows
+// Bulk commands are captured as the command they carry, for replay to send
+// through a region of its own.
+static void record_incoming(int client, const char *buffer, size_t len, int passed_fd) {
+    if (!g_recorder) return;
+    const jw_msg_header_t *hdr = (const jw_msg_header_t*)buffer;
+    if (hdr->cmd == JW_CMD_BULK_ATTACH) return;
+    if (hdr->type == JW_MSG_TYPE_CMD && hdr->cmd == JW_CMD_COMMIT &&
+        len >= sizeof(jw_msg_header_t) + offsetof(jw_payload_commit_t, input_serial)) {
+        const jw_payload_commit_t *p = (const jw_payload_commit_t*)(buffer + sizeof(jw_msg_header_t));
+        jw_display_t *disp = find_display(p->display_id);
+        if (disp && disp->shm_ptr) {
+            size_t size = (size_t)disp->canvas_w * disp->canvas_h * jw_format_bpp(disp->canvas_format);
+            jw_record_canvas(g_recorder, client, disp->id, disp->shm_ptr, size);
+        }
+    }
+    jw_record_message(g_recorder, client, buffer, len, passed_fd);
+}
+
+static void bulk_detach(int slot) {
+    jw_bulk_region_t *bulk = &g_bulk[slot];
+    if (bulk->ptr) munmap(bulk->ptr, bulk->size);
+    free(bulk->copy);
+    memset(bulk, 0, sizeof(*bulk));
+}
+
+// Map the client's bulk region, replacing the one it had
+static int bulk_attach(int slot, int fd, uint32_t size) {
+    struct stat st;
+    if (fd < 0 || size == 0 || size > JW_BULK_MAX_SIZE) return -1;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)size) return -1;
+#ifdef F_GET_SEALS
+    // Shrunk under the copy in bulk_message() it would fault
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals == -1 || !(seals & F_SEAL_SHRINK)) {
+        fprintf(stderr, "bulk fd not sealed against shrinking\n");
+        return -1;
+    }
+#endif
+    void *ptr = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) return -1;
+    bulk_detach(slot);
+    g_bulk[slot].ptr = (char*)ptr;
+    g_bulk[slot].size = size;
+    return 0;
+}
+
+// The command a JW_CMD_BULK message points at in the client's region: its
+// length, with *msg set to it, or -1 if the range is no good. The command is
+// copied out first, the client could change it between checks and use.
+static ssize_t bulk_message(int slot, const char *buffer, ssize_t len, char **msg) {
+    jw_bulk_region_t *bulk = &g_bulk[slot];
+    if (!bulk->ptr || len < (ssize_t)(sizeof(jw_msg_header_t) + sizeof(jw_payload_bulk_t))) return -1;
+    const jw_payload_bulk_t *p = (const jw_payload_bulk_t*)(buffer + sizeof(jw_msg_header_t));
+    if (p->length < sizeof(jw_msg_header_t) || (uint64_t)p->offset + p->length > bulk->size) return -1;
+
+    if (p->length > bulk->copy_cap) {
+        char *grown = (char*)realloc(bulk->copy, p->length);
+        if (!grown) return -1;
+        bulk->copy = grown;
+        bulk->copy_cap = p->length;
+    }
+    memcpy(bulk->copy, bulk->ptr + p->offset, p->length);
+
+    const jw_msg_header_t *inner = (const jw_msg_header_t*)bulk->copy;
+    if (inner->type != JW_MSG_TYPE_CMD || inner->cmd == JW_CMD_BULK || inner->cmd == JW_CMD_BULK_ATTACH) return -1;
+    *msg = bulk->copy;
+    return (ssize_t)p->length;
+}
+
+// Display a command works on, for those whose payload starts with a display id
+static jw_display_t *message_display(const char *buffer, ssize_t len) {
+    const jw_msg_header_t *hdr = (const jw_msg_header_t*)buffer;
+    if (hdr->type != JW_MSG_TYPE_CMD || len < (ssize_t)(sizeof(jw_msg_header_t) + sizeof(int))) return NULL;
+    switch (hdr->cmd) {
+        case JW_CMD_CREATE_CANVAS:
+        case JW_CMD_COMMIT:
+        case JW_CMD_DRAW:
+        case JW_CMD_CREATE_LAYER:
+        case JW_CMD_UPDATE_LAYER:
+        case JW_CMD_DESTROY_LAYER:
+        case JW_CMD_TRANSACTION:
+        case JW_CMD_INPUT:
+        case JW_CMD_CAPTURE: {
+            int id;
+            memcpy(&id, buffer + sizeof(jw_msg_header_t), sizeof(id));
+            return find_display(id);
+        }
+        default:
+            return NULL;
+    }
+}
+
+// Frame length of the fastest output, budgets renew at this pace
+static uint64_t sched_frame_ns(void) {
+    int hz = 60;
+    for (jw_display_t *d = g_displays; d; d = d->next) {
+        if (d->refresh_hz > hz) hz = d->refresh_hz;
+    }
+    return 1000000000ull / hz;
+}
+
+// Start a new frame when the old one is over: every client gets its budget back.
+// Returns ns until the next frame starts.
+static uint64_t sched_tick(uint64_t now) {
+    uint64_t frame = sched_frame_ns();
+    if (now - g_frame_start_ns >= frame) {
+        g_frame_start_ns = now;
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            g_sched[i].used_ns = 0;
+            g_sched[i].throttled = false;
+        }
+    }
+    return g_frame_start_ns + frame - now;
+}
+
+// Charge a handled message to client i
+static void sched_charge(int i, uint64_t ns) {
+    jw_client_sched_t *cs = &g_sched[i];
+    cs->used_ns += ns;
+    uint64_t budget = k_frame_budget_ns[cs->priority];
+    if (budget && cs->used_ns >= budget && !cs->throttled) {
+        cs->throttled = true;
+        g_client_stats[i].throttled++;
+    }
+}
+
+// Ready clients in service order: priority class, then the soonest vsync
+static int sched_order(const int *sockets, const fd_set *ready, int order[MAX_CLIENTS]) {
+    int n = 0;
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        int sd = sockets[i];
+        if (sd <= 0 || (!FD_ISSET(sd, ready) && !g_parked[i].len)) continue;
+
+        jw_client_sched_t *cs = &g_sched[i];
+        cs->due_ns = UINT64_MAX; // no display, nothing to be late for
+        for (jw_display_t *d = g_displays; d; d = d->next) {
+            if (d->owner != sd) continue;
+            uint64_t due = d->last_present_ns + 1000000000ull / d->refresh_hz;
+            if (due < cs->due_ns) cs->due_ns = due;
+        }
+
+        int k = n++;
+        while (k > 0) {
+            const jw_client_sched_t *prev = &g_sched[order[k - 1]];
+            if (prev->priority > cs->priority || (prev->priority == cs->priority && prev->due_ns <= cs->due_ns)) break;
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = i;
+    }
+    return n;
+}
+
+// Stats report for JW_CMD_STATS after `out`, sized to fit one message
+static size_t build_stats(uint8_t *out, size_t cap, const int *sockets, int self) {
+    jw_stats_reply_t *reply = (jw_stats_reply_t*)out;
+    size_t len = sizeof(jw_stats_reply_t);
+    memset(reply, 0, sizeof(*reply));
+    reply->uptime_ms = (jw_stats_now_ns() - g_start_ns) / 1000000;
+    jw_mem_stats_t mem;
+    jw_mem_get_stats(&mem);
+    reply->huge_bytes = mem.hugetlb_bytes + mem.thp_bytes;
+    reply->locked_bytes = mem.locked_bytes;
+    reply->alloc_fallbacks = mem.fallbacks;
+
+    for (int i = 0; i < MAX_CLIENTS && len + sizeof(jw_stats_client_t) <= cap; i++) {
+        int sd = sockets[i];
+        if (sd <= 0) continue;
+        const jw_client_stats_t *cs = &g_client_stats[i];
+        jw_stats_client_t c = {0};
+        c.slot = (uint8_t)i;
+        c.flags = i == self ? JW_STATS_F_SELF : 0;
+        c.commit_rate = (uint16_t)(cs->commit_rate > UINT16_MAX ? UINT16_MAX : cs->commit_rate);
+        c.commits = (uint32_t)jw_stat_get(&cs->counters.commits);
+        c.bytes_uploaded = jw_stat_get(&cs->counters.bytes_uploaded);
+        c.shm_bytes = jw_resource_owner_bytes(&g_resources, sd);
+        for (jw_display_t *d = g_displays; d; d = d->next) {
+            if (d->owner == sd && d->shm_ptr) c.shm_bytes += (size_t)d->canvas_w * d->canvas_h * jw_format_bpp(d->canvas_format);
+        }
+        int queued = 0;
+        if (g_uring) c.queued_bytes = (uint32_t)jw_uring_buffered(g_uring, sd);
+        else if (ioctl(sd, FIONREAD, &queued) == 0) c.queued_bytes = (uint32_t)queued;
+        uint32_t us[4];
+        jw_hist_summary(&cs->counters.latency, us);
+        memcpy(c.latency_us, us, sizeof(us)); // packed, no pointer to it
+        c.priority = g_sched[i].priority;
+        c.throttled = cs->throttled;
+        memcpy(out + len, &c, sizeof(c));
+        len += sizeof(c);
+        reply->client_count++;
+    }
+
+    for (jw_display_t *d = g_displays; d && len + sizeof(jw_stats_output_t) <= cap; d = d->next) {
+        jw_stats_output_t o = {0};
+        o.display_id = d->id;
+        o.frames = (uint32_t)jw_stat_get(&d->stats.frames);
+        o.missed_vsyncs = (uint32_t)jw_stat_get(&d->stats.missed_vsyncs);
+        o.refresh_hz = (uint16_t)d->refresh_hz;
+        o.w = (uint16_t)d->w;
+        o.h = (uint16_t)d->h;
+        uint64_t screen_px = jw_stat_get(&d->stats.screen_px);
+        o.dirty_permille = screen_px ? (uint16_t)(jw_stat_get(&d->stats.dirty_px) * 1000 / screen_px) : 0;
+        uint32_t us[4];
+        jw_hist_summary(&d->stats.composite, us);
+        memcpy(o.composite_us, us, sizeof(us));
+        jw_hist_summary(&d->stats.present, us);
+        memcpy(o.present_us, us, sizeof(us));
+        jw_hist_summary(&d->stats.commit_to_present, us);
+        memcpy(o.commit_to_present_us, us, sizeof(us));
+        jw_hist_summary(&d->stats.input_to_photon, us);
+        memcpy(o.input_to_photon_us, us, sizeof(us));
+        jw_hist_summary(&d->stats.tile_hash, us);
+        memcpy(o.tile_hash_us, us, sizeof(us));
+        memcpy(out + len, &o, sizeof(o));
+        len += sizeof(o);
+        reply->output_count++;
+    }
+    return len;
+}
+
+// As the reply to msg_id (JW_MSG_TYPE_RESP) or as a periodic event (JW_MSG_TYPE_EVT)
+static void send_stats(int sd, uint8_t type, uint16_t msg_id, const int *sockets, int self) {
+    uint8_t buf[JW_MSG_MAX_LEN];
+    jw_msg_header_t hdr = {0};
+    hdr.type = type;
+    hdr.cmd = type == JW_MSG_TYPE_RESP ? JW_CMD_RESPONSE : JW_CMD_STATS;
+    hdr.msg_id = msg_id;
+
+    size_t len = sizeof(jw_msg_header_t);
+    if (type == JW_MSG_TYPE_RESP) {
+        jw_payload_response_t resp_data = {0};
+        memcpy(buf + len, &resp_data, sizeof(resp_data));
+        len += sizeof(resp_data);
+    }
+    len += build_stats(buf + len, sizeof(buf) - len - JW_CRC_LEN, sockets, self);
+
+    hdr.len = (uint16_t)len;
+    memcpy(buf, &hdr, sizeof(hdr));
+    core_send(sd, buf, len, -1);
+}
+
+// Once a second: commit rates. Then any periodic stats that are due.
+static void stats_tick(const int *sockets) {
+    static uint64_t rate_start = 0;
+    uint64_t now = jw_stats_now_ns();
+    bool new_second = now - rate_start >= 1000000000ull;
+    if (new_second) rate_start = now;
+
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        jw_client_stats_t *cs = &g_client_stats[i];
+        if (sockets[i] <= 0) continue;
+        if (new_second) {
+            uint64_t commits = jw_stat_get(&cs->counters.commits);
+            cs->commit_rate = (uint32_t)(commits - cs->rate_base);
+            cs->rate_base = commits;
+        }
+        if (cs->interval_ms && now >= cs->next_report_ns) {
+            cs->next_report_ns = now + (uint64_t)cs->interval_ms * 1000000;
+            send_stats(sockets[i], JW_MSG_TYPE_EVT, 0, sockets, i);
+        }
+    }
+}
+
 int main(int argc, char *argv[]) {
+    size_t resource_budget_mb = DEFAULT_RESOURCE_BUDGET_MB;
+    const char *record_path = NULL;
+    bool headless = false;
+    bool io_uring = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--resource-budget") == 0 && i + 1 < argc) {
+            resource_budget_mb = (size_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rotate") == 0 && i + 1 < argc) {
+            int deg = atoi(argv[++i]);
+            if (deg % 90 != 0 || deg < 0 || deg > 270) {
+                fprintf(stderr, "--rotate takes 0, 90, 180 or 270\n");
+                return 1;
+            }
+            g_rotation = (jw_rotation_t)(deg / 90);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--alloc") == 0 && i + 1 < argc) {
+            int mode = jw_mem_parse_mode(argv[++i]);
+            if (mode < 0) {
+                fprintf(stderr, "--alloc takes huge, populate and lock, comma separated, or none\n");
+                return 1;
+            }
+            jw_mem_set_mode((unsigned)mode);
+        } else if (strcmp(argv[i], "--auto-damage") == 0) {
+            g_auto_damage = true;
+        } else if (strcmp(argv[i], "--io-uring") == 0) {
+            io_uring = true;
+        } else if (strcmp(argv[i], "--prewarm") == 0 && i + 1 < argc) {
+            g_warm_target = atoi(argv[++i]);
+            if (g_warm_target < 0) g_warm_target = 0;
+            if (g_warm_target > MAX_PREWARM) g_warm_target = MAX_PREWARM;
+        } else {
+            fprintf(stderr, "Usage: %s [--resource-budget MB] [--rotate 0|90|180|270] [--record FILE] [--headless] [--prewarm N] [--auto-damage] [--io-uring] [--alloc huge,populate,lock]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Headless: no windows shown, for replays and benchmarks
+    if (headless) setenv("SDL_VIDEODRIVER", "dummy", 0);
+    g_window_flags = headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI;
+    g_renderer_flags = headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED;
+
     // SDL Init
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         fprintf(stderr, "SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         return 1;
     }
 
+    if (pipe(g_wake_pipe) == -1) {
+        perror("pipe");
+        return 1;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(g_wake_pipe[i], F_SETFL, O_NONBLOCK);
+        fcntl(g_wake_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+    jw_resource_cache_init(&g_resources, resource_budget_mb * 1024 * 1024);
+    g_start_ns = jw_stats_now_ns();
+    for (int i = 0; i < g_warm_target; i++) prewarm_output();
+
+    if (record_path) {
+        g_recorder = jw_record_open(record_path);
+        if (!g_recorder) return 1;
+        printf("Recording to %s\n", record_path);
+    }
+    // Leave through the cleanup below so recordings end cleanly
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN); // a client gone mid-reply shows up as a disconnect instead
+
     // Socket Setup
     int server_fd;
     struct sockaddr_un addr;
@@ -93,30 +1682,55 @@ int main(int argc, char *argv[]) {
         client_sockets[i] = 0;
     }
 
-    printf("jw_mt_core started on %s...\n", JW_MT_SOCKET_PATH);
+    if (io_uring) {
+        g_uring = jw_uring_create();
+        if (g_uring) {
+            jw_uring_watch(g_uring, server_fd);
+            jw_uring_watch(g_uring, g_wake_pipe[0]);
+        } else {
+            fprintf(stderr, "Staying on select()\n");
+        }
+    }
+
+    printf("jw_mt_core started on %s%s...\n", JW_MT_SOCKET_PATH, g_uring ? " (io_uring)" : "");
 
     bool running = true;
-    while(running) {
+    while(running && !g_quit) {
         fd_set readfds;
         FD_ZERO(&readfds);
         FD_SET(server_fd, &readfds);
-        int max_sd = server_fd;
+        FD_SET(g_wake_pipe[0], &readfds);
+        int max_sd = server_fd > g_wake_pipe[0] ? server_fd : g_wake_pipe[0];
 
+        // Clients out of budget stay unread until the next frame, parked ones
+        // until their message went through
+        uint64_t frame_left = sched_tick(jw_stats_now_ns());
+        bool parked = false;
         for (int i = 0 ; i < MAX_CLIENTS; i++) {
             int sd = client_sockets[i];
-            if(sd > 0) FD_SET(sd, &readfds);
+            if (sd > 0 && g_parked[i].len) parked = true;
+            else if(sd > 0 && !g_sched[i].throttled) FD_SET(sd, &readfds);
             if(sd > max_sd) max_sd = sd;
         }
 
-        // Use timeout for select so we can poll SDL events
+        // Use timeout for select so we can poll SDL events, and wake for the next frame
         struct timeval tv = {0, 10000}; // 10ms
-        int activity = select(max_sd + 1, &readfds, NULL, NULL, &tv);
+        if (frame_left / 1000 < (uint64_t)tv.tv_usec) tv.tv_usec = (suseconds_t)(frame_left / 1000);
+        if (parked) tv.tv_usec = 1000; // render threads wake us when done, this is a fallback
+        int activity = g_uring ? jw_uring_select(g_uring, &readfds, (uint64_t)tv.tv_usec * 1000)
+                               : select(max_sd + 1, &readfds, NULL, NULL, &tv);
 
         if ((activity < 0) && (errno != EINTR)) {
             perror("select error");
         }
+        if (activity <= 0) FD_ZERO(&readfds);
+
+        if (FD_ISSET(g_wake_pipe[0], &readfds)) {
+            char drain[64];
+            while (read(g_wake_pipe[0], drain, sizeof(drain)) > 0) {}
+        }
 
-        if (activity > 0) {
+        if (activity > 0 || parked) {
             // Incoming connection
             if (FD_ISSET(server_fd, &readfds)) {
                 int new_socket = accept(server_fd, NULL, NULL);
@@ -124,195 +1738,482 @@ int main(int argc, char *argv[]) {
                     perror("accept");
                 } else {
                     printf("New connection, socket fd is %d\n", new_socket);
-                    for (int i = 0; i < MAX_CLIENTS; i++) {
+                    if (g_uring && jw_uring_add_client(g_uring, new_socket) != 0) {
+                        close(new_socket);
+                        new_socket = -1;
+                    }
+                    for (int i = 0; i < MAX_CLIENTS && new_socket >= 0; i++) {
                         if (client_sockets[i] == 0) {
                             client_sockets[i] = new_socket;
+                            memset(&g_client_stats[i], 0, sizeof(g_client_stats[i]));
+                            memset(&g_sched[i], 0, sizeof(g_sched[i]));
+                            memset(&g_wire[i], 0, sizeof(g_wire[i]));
+                            g_sched[i].priority = JW_PRIO_NORMAL;
+                            g_client_gen[i]++;
+                            jw_record_event(g_recorder, i, JW_REC_CONNECT);
                             break;
                         }
                     }
                 }
             }
 
-            // IO operations on some other socket
-            for (int i = 0; i < MAX_CLIENTS; i++) {
+            // IO operations on some other socket, most urgent first
+            int order[MAX_CLIENTS];
+            int ready = sched_order(client_sockets, &readfds, order);
+            for (int k = 0; k < ready; k++) {
+                int i = order[k];
                 int sd = client_sockets[i];
-                if (sd > 0 && FD_ISSET(sd, &readfds)) {
-                    char buffer[1024] = {0};
-                    ssize_t valread = read(sd, buffer, 1024);
+                if (sd > 0) {
+                    char buffer[JW_MSG_MAX_LEN] = {0};
+                    int passed_fd = -1; // fd sent along with the message, if any
+                    uint64_t recv_ns = jw_stats_now_ns();
+                    ssize_t valread;
+                    jw_parked_msg_t *pk = &g_parked[i];
+                    bool retry = pk->len > 0; // checked and recorded when it first came in
+                    if (retry) {
+                        memcpy(buffer, pk->buf, pk->len);
+                        valread = pk->len;
+                        passed_fd = pk->fd;
+                        recv_ns = pk->recv_ns;
+                        pk->len = 0;
+                    } else {
+                        valread = g_uring ? jw_uring_recv(g_uring, sd, buffer, sizeof(buffer), &passed_fd)
+                                          : recv_msg_fd(sd, buffer, sizeof(buffer), &passed_fd);
+                    }
                     
                     if (valread <= 0) {
                         // Somebody disconnected
                         getpeername(sd, (struct sockaddr*)&addr, (socklen_t*)&addr);
                         printf("Host disconnected, fd %d\n", sd);
+                        jw_resource_free_owner(&g_resources, sd);
+                        jw_record_event(g_recorder, i, JW_REC_DISCONNECT);
+                        if (g_uring) jw_uring_remove_client(g_uring, sd);
                         close(sd);
                         client_sockets[i] = 0;
-                    } else {
+                        g_client_stats[i].interval_ms = 0;
+                        memset(&g_wire[i], 0, sizeof(g_wire[i]));
+                        bulk_detach(i);
+                        for (jw_display_t *d = g_displays; d; d = d->next) {
+                            if (d->input_listener == sd) d->input_listener = 0;
+                            if (d->capture.client == sd) {
+                                pthread_mutex_lock(&d->lock);
+                                capture_end(d);
+                                pthread_mutex_unlock(&d->lock);
+                            }
+                        }
+                    } else if (!retry) {
                         // Protocol: Binary
                         if (valread < sizeof(jw_msg_header_t)) {
                              fprintf(stderr, "Received incomplete header (%ld bytes)\n", valread);
+                             if (passed_fd >= 0) close(passed_fd);
                              continue;
                         }
                         
-                        jw_msg_header_t *hdr = (jw_msg_header_t*)buffer;
-                        
-                        // Validate Checksum (simple full buffer check)
-                        if (!jw_validate_checksum((uint8_t*)buffer, valread)) {
-                             fprintf(stderr, "Checksum mismatch! Expected %d\n", hdr->checksum);
+                        // Checksum or CRC, the CRC is dropped here
+                        uint8_t integrity = g_wire[i].sd == sd ? g_wire[i].integrity : JW_INTEGRITY_CHECKSUM;
+                        size_t opened = jw_msg_open((uint8_t*)buffer, (size_t)valread, integrity);
+                        if (!opened) {
+                             fprintf(stderr, "%s mismatch from fd %d, message dropped\n",
+                                     integrity == JW_INTEGRITY_CRC32C ? "CRC32C" : "Checksum", sd);
+                             if (passed_fd >= 0) close(passed_fd);
                              continue;
                         }
+                        valread = (ssize_t)opened;
+                    }
+                    if (valread > 0) {
+                        char *msg = buffer;
+                        ssize_t msg_len = valread;
+                        jw_msg_header_t *hdr = (jw_msg_header_t*)buffer;
+
+                        // The command itself lies in the client's bulk region
+                        jw_msg_header_t bulk_hdr;
+                        if (hdr->type == JW_MSG_TYPE_CMD && hdr->cmd == JW_CMD_BULK) {
+                            msg_len = bulk_message(i, buffer, valread, &msg);
+                            if (msg_len < 0) {
+                                jw_payload_response_t resp_data = {0};
+                                resp_data.status = -1;
+                                send_response(sd, hdr->msg_id, &resp_data);
+                                if (passed_fd >= 0) close(passed_fd);
+                                continue;
+                            }
+                            memcpy(&bulk_hdr, msg, sizeof(bulk_hdr));
+                            bulk_hdr.msg_id = hdr->msg_id;
+                            hdr = &bulk_hdr;
+                        }
+                        if (!retry) record_incoming(i, msg, (size_t)msg_len, passed_fd);
+
+                        // The render thread is composing this display: come back
+                        // to it instead of waiting, other clients go on meanwhile
+                        jw_display_t *target = message_display(msg, msg_len);
+                        bool busy = target && pthread_mutex_trylock(&target->lock) != 0;
+                        if (!busy && target && hdr->cmd == JW_CMD_CREATE_CANVAS && target->capture.copying) {
+                            // A capture copy may read the canvas this unmaps
+                            pthread_mutex_unlock(&target->lock);
+                            busy = true;
+                        }
+                        if (busy) {
+                            memcpy(pk->buf, buffer, valread);
+                            pk->len = valread;
+                            pk->fd = passed_fd;
+                            pk->recv_ns = recv_ns;
+                            continue;
+                        }
+                        bool deferred = false; // reply goes out with the frame, see present_ready()
                         
                         // Process Command
                         if (hdr->type == JW_MSG_TYPE_CMD) {
                             switch (hdr->cmd) {
                                 case JW_CMD_CREATE_DISPLAY: {
-                                    if (valread < sizeof(jw_msg_header_t) + sizeof(jw_payload_create_display_t)) break;
-                                    jw_payload_create_display_t *p = (jw_payload_create_display_t*)(buffer + sizeof(jw_msg_header_t));
-                                    
-                                    printf("CMD: Create Display '%s' (%dx%d)\n", p->name, p->w, p->h);
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_create_display_t)) break;
+                                    jw_payload_create_display_t *p = (jw_payload_create_display_t*)(msg + sizeof(jw_msg_header_t));
                                     
-                                    jw_display_t *new_disp = (jw_display_t*)malloc(sizeof(jw_display_t));
-                                    memset(new_disp, 0, sizeof(jw_display_t));
-                                    new_disp->id = ++g_display_id_counter;
-                                    new_disp->w = p->w;
-                                    new_disp->h = p->h;
-                                    new_disp->window = SDL_CreateWindow(p->name, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, p->w, p->h, SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
-                                    
-                                    if (new_disp->window) {
-                                        new_disp->renderer = SDL_CreateRenderer(new_disp->window, -1, SDL_RENDERER_ACCELERATED);
-                                        if (new_disp->renderer) {
-                                             new_disp->texture = SDL_CreateTexture(new_disp->renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, p->w, p->h);
-                                        }
-                                    }
-
-                                    if (!new_disp->texture) {
-                                        printf("Failed to create SDL resources: %s\n", SDL_GetError());
-                                    } else {
-                                        new_disp->next = g_displays;
-                                        g_displays = new_disp;
-                                    }
+                                    char name[sizeof(p->name) + 1] = {0};
+                                    memcpy(name, p->name, sizeof(p->name));
+                                    printf("CMD: Create Display '%s' (%dx%d, format %d)\n", name, p->w, p->h, p->format);
+                                    jw_display_t *disp = create_display(name, p->w, p->h, (jw_format_t)p->format, 0, sd);
                                     
                                     // Send Response
-                                    jw_msg_header_t resp_hdr = {0};
-                                    resp_hdr.type = JW_MSG_TYPE_RESP;
-                                    resp_hdr.cmd = JW_CMD_RESPONSE;
-                                    resp_hdr.msg_id = hdr->msg_id;
-                                    resp_hdr.len = sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t);
-                                    
                                     jw_payload_response_t resp_data = {0};
-                                    resp_data.status = new_disp->texture ? 0 : -1;
-                                    resp_data.data.new_id = new_disp->id;
-                                    
-                                    uint8_t resp_buf[256];
-                                    memcpy(resp_buf, &resp_hdr, sizeof(jw_msg_header_t));
-                                    memcpy(resp_buf + sizeof(jw_msg_header_t), &resp_data, sizeof(jw_payload_response_t));
-                                    resp_buf[6] = jw_calculate_checksum(resp_buf, resp_hdr.len);
-                                    
-                                    send(sd, resp_buf, resp_hdr.len, 0);
+                                    resp_data.status = disp ? 0 : -1;
+                                    resp_data.data.new_id = disp ? disp->id : 0;
+                                    send_response(sd, hdr->msg_id, &resp_data);
                                     break;
                                 }
                                 case JW_CMD_CREATE_CANVAS: {
-                                    if (valread < sizeof(jw_msg_header_t) + sizeof(jw_payload_create_canvas_t)) break;
-                                    jw_payload_create_canvas_t *p = (jw_payload_create_canvas_t*)(buffer + sizeof(jw_msg_header_t));
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_create_canvas_t)) break;
+                                    jw_payload_create_canvas_t *p = (jw_payload_create_canvas_t*)(msg + sizeof(jw_msg_header_t));
                                     
                                     printf("CMD: Create Canvas for Display %d (%dx%d)\n", p->display_id, p->w, p->h);
                                     
                                     jw_display_t *disp = find_display(p->display_id);
-                                    int status = -1;
-                                    char msg_buf[64] = "ERROR";
-                                    
-                                    if (disp) {
-                                         snprintf(disp->shm_name, sizeof(disp->shm_name), "/jw_shm_%d", p->display_id);
-                                         shm_unlink(disp->shm_name);
-                                         int fd = shm_open(disp->shm_name, O_CREAT | O_RDWR, 0666);
-                                         if (fd >= 0) {
-                                             if (ftruncate(fd, disp->w * disp->h * 4) != -1) {
-                                                 disp->shm_fd = fd;
-                                                 disp->shm_ptr = mmap(0, disp->w * disp->h * 4, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-                                                 if (disp->shm_ptr != MAP_FAILED) {
-                                                     status = 0;
-                                                     strncpy(msg_buf, disp->shm_name, 63);
-                                                 } else {
-                                                     perror("mmap failed"); close(fd); shm_unlink(disp->shm_name);
-                                                 }
-                                             } else {
-                                                  perror("ftruncate"); close(fd); shm_unlink(disp->shm_name);
-                                             }
-                                         } else {
-                                             fprintf(stderr, "shm_open failed: %s\n", strerror(errno));
-                                         }
-                                    }
+                                    int status = disp ? create_canvas(disp, p->w, p->h, (jw_format_t)p->format) : -1;
                                     
                                     // Response
-                                    jw_msg_header_t resp_hdr = {0};
-                                    resp_hdr.type = JW_MSG_TYPE_RESP;
-                                    resp_hdr.cmd = JW_CMD_RESPONSE;
-                                    resp_hdr.msg_id = hdr->msg_id;
-                                    resp_hdr.len = sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t);
-                                    
                                     jw_payload_response_t resp_data = {0};
                                     resp_data.status = status;
-                                    strncpy(resp_data.data.message, msg_buf, 63);
-                                    
-                                    uint8_t resp_buf[256];
-                                    memcpy(resp_buf, &resp_hdr, sizeof(jw_msg_header_t));
-                                    memcpy(resp_buf + sizeof(jw_msg_header_t), &resp_data, sizeof(jw_payload_response_t));
-                                    resp_buf[6] = jw_calculate_checksum(resp_buf, resp_hdr.len);
-                                    send(sd, resp_buf, resp_hdr.len, 0);
+                                    strncpy(resp_data.data.message, status == 0 ? disp->shm_name : "ERROR", 63);
+                                    send_response_fd(sd, hdr->msg_id, &resp_data, status == 0 ? disp->shm_fd : -1);
+                                    break;
+                                }
+                                case JW_CMD_CREATE_SURFACE: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + offsetof(jw_payload_create_surface_t, refresh_hz)) break;
+                                    jw_payload_create_surface_t *p = (jw_payload_create_surface_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    char name[sizeof(p->name) + 1] = {0};
+                                    memcpy(name, p->name, sizeof(p->name));
+                                    printf("CMD: Create Surface '%s' (%dx%d, format %d, canvas format %d)\n", name, p->w, p->h, p->format, p->canvas_format);
+                                    int refresh_hz = msg_len >= sizeof(jw_msg_header_t) + sizeof(jw_payload_create_surface_t) ? p->refresh_hz : 0;
+                                    jw_display_t *disp = create_display(name, p->w, p->h, (jw_format_t)p->format, refresh_hz, sd);
+                                    if (disp) {
+                                        pthread_mutex_lock(&disp->lock);
+                                        int status = create_canvas(disp, p->canvas_w, p->canvas_h, (jw_format_t)p->canvas_format);
+                                        pthread_mutex_unlock(&disp->lock);
+                                        if (status != 0) {
+                                            destroy_display(disp);
+                                            disp = NULL;
+                                        }
+                                    }
+
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = disp ? 0 : -1;
+                                    resp_data.data.new_id = disp ? disp->id : 0;
+                                    send_response_fd(sd, hdr->msg_id, &resp_data, disp ? disp->shm_fd : -1);
                                     break;
                                 }
                                 case JW_CMD_COMMIT: {
-                                    if (valread < sizeof(jw_msg_header_t) + sizeof(jw_payload_commit_t)) break;
-                                    jw_payload_commit_t *p = (jw_payload_commit_t*)(buffer + sizeof(jw_msg_header_t));
+                                    if (msg_len < sizeof(jw_msg_header_t) + offsetof(jw_payload_commit_t, input_serial)) break;
+                                    jw_payload_commit_t *p = (jw_payload_commit_t*)(msg + sizeof(jw_msg_header_t));
+                                    bool has_serial = msg_len >= sizeof(jw_msg_header_t) + offsetof(jw_payload_commit_t, damage);
+                                    bool has_damage = msg_len >= sizeof(jw_msg_header_t) + sizeof(jw_payload_commit_t) && p->damage.w > 0;
                                     
                                     jw_display_t *disp = find_display(p->display_id);
-                                    if (disp && disp->shm_ptr && disp->texture) {
-                                        void *pixels;
-                                        int pitch;
-                                        if (SDL_LockTexture(disp->texture, NULL, &pixels, &pitch) == 0) {
-                                            memcpy(pixels, disp->shm_ptr, disp->w * disp->h * 4);
-                                            SDL_UnlockTexture(disp->texture);
+                                    if (disp && disp->texture) {
+                                        frame_requested(disp, recv_ns, has_serial ? p->input_serial : 0);
+                                        if (has_damage) {
+                                            jw_rect_t area = { p->damage.x, p->damage.y, p->damage.w, p->damage.h };
+                                            damage_canvas(disp, &area);
+                                        } else if (g_auto_damage) {
+                                            disp->canvas_committed = true;
+                                        } else {
+                                            // Canvas content is opaque to us, take whatever shows it whole
+                                            for (int k = 0; k < disp->layer_count; k++) {
+                                                if (disp->z[k].layer->content == JW_LAYER_CONTENT_CANVAS) damage_layer(disp, disp->z[k].layer);
+                                            }
                                         }
-                                        SDL_RenderClear(disp->renderer);
-                                        SDL_RenderCopy(disp->renderer, disp->texture, NULL, NULL);
-                                        SDL_RenderPresent(disp->renderer);
+                                        deferred = queue_frame(disp, i, hdr->msg_id, recv_ns);
                                     }
+                                    jw_stat_add(&g_client_stats[i].counters.commits, 1);
                                     
                                     // ACK
-                                    jw_msg_header_t resp_hdr = {0};
-                                    resp_hdr.type = JW_MSG_TYPE_RESP;
-                                    resp_hdr.cmd = JW_CMD_RESPONSE;
-                                    resp_hdr.msg_id = hdr->msg_id;
-                                    resp_hdr.len = sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t); // Fixed length response
-                                    
+                                    if (!deferred) {
+                                        jw_payload_response_t resp_data = {0};
+                                        resp_data.status = 0;
+                                        send_response(sd, hdr->msg_id, &resp_data);
+                                    }
+                                    break;
+                                }
+                                case JW_CMD_DRAW: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_draw_t)) break;
+                                    jw_payload_draw_t *p = (jw_payload_draw_t*)(msg + sizeof(jw_msg_header_t));
+                                    const jw_draw_op_t *ops = (const jw_draw_op_t*)(msg + sizeof(jw_msg_header_t) + sizeof(jw_payload_draw_t));
+                                    size_t ops_len = msg_len - sizeof(jw_msg_header_t) - sizeof(jw_payload_draw_t);
+
+                                    jw_display_t *disp = find_display(p->display_id);
+                                    int status = -1;
+                                    if (disp && disp->texture && p->count * sizeof(jw_draw_op_t) <= ops_len) {
+                                        status = set_draw_list(disp, ops, p->count, (p->flags & JW_DRAW_LIST_APPEND) != 0);
+                                        if (status == 0 && (p->flags & JW_DRAW_LIST_COMMIT)) {
+                                            frame_requested(disp, recv_ns, 0);
+                                            deferred = queue_frame(disp, i, hdr->msg_id, recv_ns);
+                                            jw_stat_add(&g_client_stats[i].counters.commits, 1);
+                                        }
+                                    }
+
+                                    if (!deferred) {
+                                        jw_payload_response_t resp_data = {0};
+                                        resp_data.status = status;
+                                        send_response(sd, hdr->msg_id, &resp_data);
+                                    }
+                                    break;
+                                }
+                                case JW_CMD_UPLOAD_RESOURCE: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_upload_resource_t)) break;
+                                    jw_payload_upload_resource_t *p = (jw_payload_upload_resource_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    int id = jw_resource_create(&g_resources, sd, passed_fd, p->w, p->h, (int)p->stride, (jw_format_t)p->format);
+                                    if (id > 0) {
+                                        passed_fd = -1; // owned by the cache now
+                                        jw_stat_add(&g_client_stats[i].counters.bytes_uploaded, (uint64_t)p->stride * p->h);
+                                        printf("CMD: Upload Resource %d (%dx%d), resident %zu KB\n", id, p->w, p->h, g_resources.used / 1024);
+                                    }
+
                                     jw_payload_response_t resp_data = {0};
-                                    resp_data.status = 0;
-                                    
-                                    uint8_t resp_buf[256];
-                                    memcpy(resp_buf, &resp_hdr, sizeof(jw_msg_header_t));
-                                    memcpy(resp_buf + sizeof(jw_msg_header_t), &resp_data, sizeof(jw_payload_response_t));
-                                    resp_buf[6] = jw_calculate_checksum(resp_buf, resp_hdr.len);
-                                    send(sd, resp_buf, resp_hdr.len, 0);
+                                    resp_data.status = id > 0 ? 0 : -1;
+                                    resp_data.data.new_id = id;
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_FREE_RESOURCE: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_free_resource_t)) break;
+                                    jw_payload_free_resource_t *p = (jw_payload_free_resource_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = jw_resource_free(&g_resources, p->resource_id, sd);
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_CREATE_LAYER: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_create_layer_t)) break;
+                                    jw_payload_create_layer_t *p = (jw_payload_create_layer_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_display_t *disp = find_display(p->display_id);
+                                    jw_layer_t *layer = disp ? create_layer(disp, &p->desc, false) : NULL;
+
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = layer ? 0 : -1;
+                                    resp_data.data.new_id = layer ? (int)layer->id : 0;
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_UPDATE_LAYER: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_update_layer_t)) break;
+                                    jw_payload_update_layer_t *p = (jw_payload_update_layer_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_display_t *disp = find_display(p->display_id);
+                                    jw_layer_t *layer = disp ? find_layer(disp, p->layer_id) : NULL;
+                                    if (layer) {
+                                        damage_layer(disp, layer);
+                                        apply_layer_desc(disp, layer, p->mask, &p->desc);
+                                        damage_layer(disp, layer);
+                                    }
+
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = layer ? 0 : -1;
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_DESTROY_LAYER: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_destroy_layer_t)) break;
+                                    jw_payload_destroy_layer_t *p = (jw_payload_destroy_layer_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_display_t *disp = find_display(p->display_id);
+                                    jw_layer_t *layer = disp ? find_layer(disp, p->layer_id) : NULL;
+                                    if (layer) destroy_layer(disp, layer);
+
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = layer ? 0 : -1;
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_TRANSACTION: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_transaction_t)) break;
+                                    jw_payload_transaction_t *p = (jw_payload_transaction_t*)(msg + sizeof(jw_msg_header_t));
+                                    const jw_txn_record_t *recs = (const jw_txn_record_t*)(msg + sizeof(jw_msg_header_t) + sizeof(jw_payload_transaction_t));
+                                    size_t recs_len = msg_len - sizeof(jw_msg_header_t) - sizeof(jw_payload_transaction_t);
+
+                                    jw_display_t *disp = find_display(p->display_id);
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = -1;
+                                    if (disp && disp->texture && p->count * sizeof(jw_txn_record_t) <= recs_len) {
+                                        int bad = validate_transaction(disp, recs, p->count);
+                                        if (bad < 0) {
+                                            // Nothing presents in between, the next frame sees all of it
+                                            apply_transaction(disp, recs, p->count);
+                                            if (p->flags & JW_TXN_PRESENT) {
+                                                frame_requested(disp, recv_ns, 0);
+                                                deferred = queue_frame(disp, i, hdr->msg_id, recv_ns);
+                                                jw_stat_add(&g_client_stats[i].counters.commits, 1);
+                                            }
+                                            resp_data.status = 0;
+                                        } else {
+                                            resp_data.data.new_id = bad;
+                                        }
+                                    }
+                                    if (!deferred) send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_STATS: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_stats_t)) break;
+                                    jw_payload_stats_t *p = (jw_payload_stats_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    g_client_stats[i].interval_ms = p->interval_ms;
+                                    g_client_stats[i].next_report_ns = jw_stats_now_ns() + (uint64_t)p->interval_ms * 1000000;
+                                    send_stats(sd, JW_MSG_TYPE_RESP, hdr->msg_id, client_sockets, i);
+                                    break;
+                                }
+                                case JW_CMD_INPUT: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_input_t)) break;
+                                    jw_payload_input_t *p = (jw_payload_input_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_display_t *disp = find_display(p->display_id);
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = disp ? 0 : -1;
+                                    if (disp && (p->flags & JW_INPUT_F_LISTEN)) disp->input_listener = sd;
+                                    if (disp && (p->flags & JW_INPUT_F_INJECT)) {
+                                        jw_event_t ev = p->event;
+                                        resp_data.data.new_id = (int)deliver_input(disp, &ev);
+                                    }
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_CAPTURE: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_capture_t)) break;
+                                    jw_payload_capture_t *p = (jw_payload_capture_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_display_t *disp = find_display(p->display_id);
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = -1;
+                                    if (disp && disp->texture) {
+                                        jw_capture_t *cap = &disp->capture;
+                                        if (p->flags & (JW_CAPTURE_F_RELEASE | JW_CAPTURE_F_STOP)) {
+                                            if (cap->client == sd && (p->flags & JW_CAPTURE_F_STOP)) {
+                                                capture_end(disp);
+                                                resp_data.status = 0;
+                                            } else if (cap->client == sd) {
+                                                // Changes that came in meanwhile go out now
+                                                cap->held = false;
+                                                if (capture_due(disp)) pthread_cond_signal(&disp->wake);
+                                                resp_data.status = 0;
+                                            }
+                                        } else {
+                                            resp_data.status = capture_start(disp, sd, hdr->msg_id, p, passed_fd);
+                                            // One-shot replies once written, see capture_announce()
+                                            deferred = resp_data.status == 0 && !cap->stream;
+                                        }
+                                    }
+                                    if (!deferred) send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_BULK_ATTACH: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_bulk_attach_t)) break;
+                                    jw_payload_bulk_attach_t *p = (jw_payload_bulk_attach_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = bulk_attach(i, passed_fd, p->size);
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_SET_PRIORITY: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_set_priority_t)) break;
+                                    jw_payload_set_priority_t *p = (jw_payload_set_priority_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = -1;
+                                    if (p->priority < JW_PRIO_COUNT) {
+                                        g_sched[i].priority = p->priority;
+                                        resp_data.status = 0;
+                                    }
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    break;
+                                }
+                                case JW_CMD_SET_INTEGRITY: {
+                                    if (msg_len < sizeof(jw_msg_header_t) + sizeof(jw_payload_set_integrity_t)) break;
+                                    jw_payload_set_integrity_t *p = (jw_payload_set_integrity_t*)(msg + sizeof(jw_msg_header_t));
+
+                                    jw_payload_response_t resp_data = {0};
+                                    resp_data.status = -1;
+                                    if (p->mode == JW_INTEGRITY_CHECKSUM || p->mode == JW_INTEGRITY_CRC32C) {
+                                        resp_data.status = 0;
+                                        resp_data.data.new_id = p->mode;
+                                    }
+                                    // The reply still goes out in the old mode
+                                    send_response(sd, hdr->msg_id, &resp_data);
+                                    if (resp_data.status == 0) {
+                                        g_wire[i].sd = sd;
+                                        g_wire[i].integrity = p->mode;
+                                    }
                                     break;
                                 }
                                 default:
                                     printf("Unknown CMD: %d\n", hdr->cmd);
                             }
                         }
+                        if (target) pthread_mutex_unlock(&target->lock);
+                        uint64_t handled_ns = jw_stats_now_ns() - recv_ns;
+                        if (!deferred) jw_hist_add(&g_client_stats[i].counters.latency, (uint32_t)(handled_ns / 1000));
+                        sched_charge(i, handled_ns);
+
+                        // Nobody claimed the passed fd
+                        if (passed_fd >= 0) close(passed_fd);
                     }
                 }
             }
         }
         
+        for (jw_display_t *d = g_displays; d; d = d->next) {
+            if (__atomic_load_n(&d->frame_ready, __ATOMIC_ACQUIRE)) present_ready(d, client_sockets);
+            if (__atomic_load_n(&d->capture.ready, __ATOMIC_ACQUIRE)) capture_poll(d);
+        }
+
+        stats_tick(client_sockets);
+        if (activity == 0) prewarm_output(); // idle, get the next window ready
+
         // Handle SDL Events
         SDL_Event e;
         while(SDL_PollEvent(&e)) {
             if (e.type == SDL_QUIT) {
                 running = false;
+            } else if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP) {
+                sdl_pointer_input(e.button.windowID, e.type == SDL_MOUSEBUTTONDOWN ? JW_INPUT_POINTER_DOWN : JW_INPUT_POINTER_UP,
+                                  e.button.button, e.button.x, e.button.y);
+            } else if (e.type == SDL_MOUSEMOTION) {
+                sdl_pointer_input(e.motion.windowID, JW_INPUT_POINTER_MOTION, 0, e.motion.x, e.motion.y);
             }
         }
     }
     
     // Cleanup
+    while (g_displays) destroy_display(g_displays);
+    while (g_warm_count > 0) {
+        g_warm_count--;
+        SDL_DestroyRenderer(g_warm[g_warm_count].renderer);
+        SDL_DestroyWindow(g_warm[g_warm_count].window);
+    }
+    jw_uring_destroy(g_uring);
+    jw_record_close(g_recorder);
+    jw_resource_cache_deinit(&g_resources);
+    close(g_wake_pipe[0]);
+    close(g_wake_pipe[1]);
     close(server_fd);
     unlink(JW_MT_SOCKET_PATH);
     SDL_Quit();
@@ -0,0 +1,151 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_mt_crcbench.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "protocol.h"
+
+/**
+ * Message integrity benchmark, no core needed.
+ *
+ * For message sizes seen on the socket it times sealing and opening a
+ * message (what sender and receiver each pay) with the header checksum and
+ * with CRC32C, on the CPU's CRC instructions and on the table. Then flips
+ * random bits in messages and counts how many each mode notices.
+ */
+
+static const size_t k_sizes[] = {
+    sizeof(jw_msg_header_t) + sizeof(jw_payload_set_priority_t),
+    sizeof(jw_msg_header_t) + sizeof(jw_payload_commit_t),
+    sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t),
+    512, 2048, JW_MSG_MAX_LEN - JW_CRC_LEN,
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void fill_msg(uint8_t *msg, size_t len, uint16_t msg_id) {
+    jw_msg_header_t hdr = {0};
+    hdr.type = JW_MSG_TYPE_CMD;
+    hdr.cmd = JW_CMD_DRAW;
+    hdr.len = (uint16_t)len;
+    hdr.msg_id = msg_id;
+    memcpy(msg, &hdr, sizeof(hdr));
+    for (size_t i = sizeof(hdr); i < len; i++) msg[i] = (uint8_t)rand();
+}
+
+// jw_msg_seal/open with the table CRC, to see what CPUs without the instructions pay
+static size_t seal_table(uint8_t *msg, size_t len) {
+    uint16_t total = (uint16_t)(len + JW_CRC_LEN);
+    memcpy(msg + 2, &total, sizeof(total));
+    msg[6] = 0;
+    uint32_t crc = jw_crc32c_table(0, msg, len);
+    memcpy(msg + len, &crc, sizeof(crc));
+    return total;
+}
+
+static size_t open_table(uint8_t *msg, size_t len) {
+    uint32_t crc;
+    len -= JW_CRC_LEN;
+    memcpy(&crc, msg + len, sizeof(crc));
+    if (crc != jw_crc32c_table(0, msg, len)) return 0;
+    uint16_t body = (uint16_t)len;
+    memcpy(msg + 2, &body, sizeof(body));
+    return len;
+}
+
+// Seal and open one message `iters` times, ns per round trip
+static double time_mode(uint8_t *msg, size_t len, int mode, int iters) {
+    size_t bad = 0;
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < iters; i++) {
+        msg[4] = (uint8_t)i; // the checksum picks its payload byte by msg_id
+        size_t sealed, opened;
+        if (mode < 0) {
+            sealed = seal_table(msg, len);
+            opened = open_table(msg, sealed);
+        } else {
+            sealed = jw_msg_seal(msg, len, (uint8_t)mode);
+            opened = jw_msg_open(msg, sealed, (uint8_t)mode);
+        }
+        bad += opened != len;
+    }
+    uint64_t t1 = now_ns();
+    if (bad) fprintf(stderr, "%zu messages did not check out\n", bad);
+    return (double)(t1 - t0) / iters;
+}
+
+// Share of single and multi bit flips each mode catches
+static void detection(int trials) {
+    static uint8_t msg[JW_MSG_MAX_LEN];
+    int caught[2][2] = {{0}};
+    for (int t = 0; t < trials; t++) {
+        size_t len = k_sizes[t % (sizeof(k_sizes) / sizeof(k_sizes[0]))];
+        int flips = t & 1 ? 1 + rand() % 8 : 1;
+        for (int mode = 0; mode < 2; mode++) {
+            fill_msg(msg, len, (uint16_t)t);
+            size_t sealed = jw_msg_seal(msg, len, (uint8_t)mode);
+            // Distinct bytes, so no flip undoes another. The length is left
+            // alone, a torn one breaks the framing anyway.
+            size_t at[8];
+            for (int f = 0; f < flips; f++) {
+                bool again;
+                do {
+                    at[f] = (size_t)rand() % sealed;
+                    again = at[f] == 2 || at[f] == 3;
+                    for (int g = 0; g < f; g++) again |= at[g] == at[f];
+                } while (again);
+                msg[at[f]] ^= (uint8_t)(1u << (rand() % 8));
+            }
+            caught[mode][t & 1] += jw_msg_open(msg, sealed, (uint8_t)mode) == 0;
+        }
+    }
+    int half = trials / 2;
+    printf("\ncorruption caught over %d messages each:\n", half);
+    printf("  %-10s  1 bit %6.2f%%   1-8 bits %6.2f%%\n", "checksum",
+           100.0 * caught[0][0] / half, 100.0 * caught[0][1] / half);
+    printf("  %-10s  1 bit %6.2f%%   1-8 bits %6.2f%%\n", "crc32c",
+           100.0 * caught[1][0] / half, 100.0 * caught[1][1] / half);
+}
+
+int main(int argc, char *argv[]) {
+    int iters = 200000;
+    if (argc == 3 && strcmp(argv[1], "--iters") == 0) {
+        iters = atoi(argv[2]);
+    } else if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--iters N]\n", argv[0]);
+        return 1;
+    }
+    if (iters <= 0) return 1;
+
+    static uint8_t msg[JW_MSG_MAX_LEN];
+    printf("seal + open, ns per message (jw_crc32c on %s)\n", jw_crc32c_impl());
+    printf("  %6s  %10s  %10s  %10s\n", "bytes", "checksum", "crc32c", "crc table");
+    for (size_t s = 0; s < sizeof(k_sizes) / sizeof(k_sizes[0]); s++) {
+        size_t len = k_sizes[s];
+        fill_msg(msg, len, 1);
+        int n = len > 1024 ? iters / 8 : iters;
+        double sum = time_mode(msg, len, JW_INTEGRITY_CHECKSUM, n);
+        double crc = time_mode(msg, len, JW_INTEGRITY_CRC32C, n);
+        double table = time_mode(msg, len, -1, n);
+        printf("  %6zu  %10.1f  %10.1f  %10.1f\n", len, sum, crc, table);
+    }
+
+    detection(200000);
+    return 0;
+}
@@ -0,0 +1,238 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_mt_latency.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <stdbool.h>
+#include "protocol.h"
+#include "shm_helper.h"
+
+/**
+ * Input latency benchmark.
+ *
+ * Injects synthetic pointer motion into its own display, reacts to each event
+ * by moving a square on the canvas and commits naming the event's serial.
+ * Prints what it saw itself (inject to commit reply) and the core's
+ * commit-to-present and input-to-photon histograms from JW_CMD_STATS.
+ */
+
+#define LAT_W 320
+#define LAT_H 240
+#define SQUARE 16
+
+static int g_sock = -1;
+static uint16_t g_msg_id = 0;
+static uint8_t g_rx[JW_MSG_MAX_LEN * 2];
+static size_t g_rx_len = 0;
+static uint8_t g_integrity = JW_INTEGRITY_CHECKSUM; // --crc
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint16_t send_cmd(uint8_t cmd, const void *payload, size_t len) {
+    uint8_t buf[256 + JW_CRC_LEN];
+    jw_msg_header_t *hdr = (jw_msg_header_t*)buf;
+    hdr->type = JW_MSG_TYPE_CMD;
+    hdr->cmd = cmd;
+    hdr->msg_id = ++g_msg_id;
+    hdr->len = (uint16_t)(sizeof(jw_msg_header_t) + len);
+    memcpy(buf + sizeof(jw_msg_header_t), payload, len);
+    uint16_t msg_id = hdr->msg_id;
+    send_msg_fd(g_sock, buf, jw_msg_seal(buf, hdr->len, g_integrity), -1);
+    return msg_id;
+}
+
+// Next whole message into out, events and replies arrive on the same stream
+static size_t next_msg(uint8_t *out, int *fd) {
+    for (;;) {
+        if (g_rx_len >= sizeof(jw_msg_header_t)) {
+            const jw_msg_header_t *hdr = (const jw_msg_header_t*)g_rx;
+            if (hdr->len < sizeof(jw_msg_header_t) || hdr->len > JW_MSG_MAX_LEN) {
+                fprintf(stderr, "Bad message length %u\n", hdr->len);
+                exit(1);
+            }
+            if (g_rx_len >= hdr->len) {
+                size_t len = hdr->len;
+                memcpy(out, g_rx, len);
+                memmove(g_rx, g_rx + len, g_rx_len - len);
+                g_rx_len -= len;
+                len = jw_msg_open(out, len, g_integrity);
+                if (!len) {
+                    fprintf(stderr, "Corrupt message from the core\n");
+                    exit(1);
+                }
+                return len;
+            }
+        }
+        int passed = -1;
+        ssize_t n = recv_msg_fd(g_sock, g_rx + g_rx_len, sizeof(g_rx) - g_rx_len, &passed);
+        if (n <= 0) {
+            fprintf(stderr, "Core went away\n");
+            exit(1);
+        }
+        if (passed >= 0) {
+            if (fd && *fd < 0) *fd = passed;
+            else close(passed);
+        }
+        g_rx_len += (size_t)n;
+    }
+}
+
+// Wait for the reply to msg_id. Input events met on the way update *serial.
+static const jw_payload_response_t *wait_reply(uint16_t msg_id, uint8_t *msg, uint32_t *serial, int *fd) {
+    for (;;) {
+        size_t len = next_msg(msg, fd);
+        const jw_msg_header_t *hdr = (const jw_msg_header_t*)msg;
+        if (hdr->type == JW_MSG_TYPE_EVT && hdr->cmd == JW_CMD_INPUT && len >= sizeof(jw_msg_header_t) + sizeof(jw_payload_input_t)) {
+            const jw_payload_input_t *p = (const jw_payload_input_t*)(msg + sizeof(jw_msg_header_t));
+            if (serial && p->event.serial > *serial) *serial = p->event.serial;
+        } else if (hdr->type == JW_MSG_TYPE_RESP && hdr->msg_id == msg_id) {
+            return (const jw_payload_response_t*)(msg + sizeof(jw_msg_header_t));
+        }
+    }
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    int count = 300;
+    int rate = 120;
+    bool crc = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) rate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--crc") == 0) crc = true;
+        else {
+            fprintf(stderr, "Usage: %s [--count N] [--rate HZ] [--crc]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (count <= 0 || rate <= 0) return 1;
+
+    g_sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, JW_MT_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(g_sock, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        perror("connect");
+        return 1;
+    }
+
+    static uint8_t msg[JW_MSG_MAX_LEN];
+
+    // Pointer feedback is what interactive is for
+    jw_payload_set_priority_t p_prio = { JW_PRIO_INTERACTIVE };
+    wait_reply(send_cmd(JW_CMD_SET_PRIORITY, &p_prio, sizeof(p_prio)), msg, NULL, NULL);
+
+    if (crc) {
+        jw_payload_set_integrity_t p_int = { JW_INTEGRITY_CRC32C };
+        const jw_payload_response_t *r = wait_reply(send_cmd(JW_CMD_SET_INTEGRITY, &p_int, sizeof(p_int)), msg, NULL, NULL);
+        if (r->status != 0) {
+            fprintf(stderr, "Core has no CRC32C mode\n");
+            return 1;
+        }
+        g_integrity = JW_INTEGRITY_CRC32C;
+        printf("CRC32C on %s\n", jw_crc32c_impl());
+    }
+
+    jw_payload_create_surface_t p_surf = {0};
+    strcpy(p_surf.name, "Latency");
+    p_surf.w = LAT_W;
+    p_surf.h = LAT_H;
+    p_surf.format = JW_PIXFMT_XRGB8888;
+    p_surf.canvas_format = JW_PIXFMT_XRGB8888;
+    int canvas_fd = -1;
+    const jw_payload_response_t *resp = wait_reply(send_cmd(JW_CMD_CREATE_SURFACE, &p_surf, sizeof(p_surf)), msg, NULL, &canvas_fd);
+    if (resp->status != 0 || canvas_fd < 0) { fprintf(stderr, "Create Surface Failed\n"); return 1; }
+    int display_id = resp->data.new_id;
+    uint32_t *canvas = mmap(0, LAT_W * LAT_H * 4, PROT_READ | PROT_WRITE, MAP_SHARED, canvas_fd, 0);
+    if (canvas == MAP_FAILED) { perror("mmap"); return 1; }
+    close(canvas_fd);
+
+    jw_payload_input_t p_input = {0};
+    p_input.display_id = display_id;
+    p_input.flags = JW_INPUT_F_LISTEN;
+    wait_reply(send_cmd(JW_CMD_INPUT, &p_input, sizeof(p_input)), msg, NULL, NULL);
+
+    uint32_t *seen_us = (uint32_t*)calloc(count, sizeof(uint32_t));
+    int sx = 0, sy = 0;
+    uint32_t serial = 0;
+    for (int n = 0; n < count; n++) {
+        uint64_t t0 = now_ns();
+
+        // Pointer sweeps diagonally across the display
+        p_input.flags = JW_INPUT_F_INJECT;
+        p_input.event.type = JW_INPUT_POINTER_MOTION;
+        p_input.event.x = (int16_t)(n * 3 % (LAT_W - SQUARE));
+        p_input.event.y = (int16_t)(n * 2 % (LAT_H - SQUARE));
+        p_input.event.timestamp = t0;
+        resp = wait_reply(send_cmd(JW_CMD_INPUT, &p_input, sizeof(p_input)), msg, &serial, NULL);
+
+        // Reaction: move the square to the pointer
+        for (int y = 0; y < SQUARE; y++) memset(&canvas[(sy + y) * LAT_W + sx], 0, SQUARE * 4);
+        int old_x = sx, old_y = sy;
+        sx = p_input.event.x;
+        sy = p_input.event.y;
+        for (int y = 0; y < SQUARE; y++) {
+            for (int x = 0; x < SQUARE; x++) canvas[(sy + y) * LAT_W + sx + x] = 0xFFFFFFFF;
+        }
+
+        jw_payload_commit_t p_commit = { display_id, serial, { 0 } };
+        p_commit.damage.x = (int16_t)(old_x < sx ? old_x : sx);
+        p_commit.damage.y = (int16_t)(old_y < sy ? old_y : sy);
+        p_commit.damage.w = (uint16_t)(abs(sx - old_x) + SQUARE);
+        p_commit.damage.h = (uint16_t)(abs(sy - old_y) + SQUARE);
+        wait_reply(send_cmd(JW_CMD_COMMIT, &p_commit, sizeof(p_commit)), msg, &serial, NULL);
+        seen_us[n] = (uint32_t)((now_ns() - t0) / 1000);
+
+        uint64_t next = t0 + 1000000000ull / rate;
+        uint64_t now = now_ns();
+        if (next > now) usleep((useconds_t)((next - now) / 1000));
+    }
+
+    qsort(seen_us, count, sizeof(uint32_t), compare_u32);
+    printf("%d events at %d Hz\n", count, rate);
+    printf("client  inject to commit reply us: p50 %u p99 %u max %u\n",
+           seen_us[count / 2], seen_us[(int)(count * 0.99)], seen_us[count - 1]);
+
+    jw_payload_stats_t p_stats = {0};
+    resp = wait_reply(send_cmd(JW_CMD_STATS, &p_stats, sizeof(p_stats)), msg, NULL, NULL);
+    const jw_stats_reply_t *reply = (const jw_stats_reply_t*)(resp + 1);
+    const jw_stats_output_t *o = (const jw_stats_output_t*)((const uint8_t*)(reply + 1) +
+                                 reply->client_count * sizeof(jw_stats_client_t));
+    for (int i = 0; i < reply->output_count; i++, o++) {
+        if (o->display_id != display_id) continue;
+        printf("core    commit to present us:      p50 %u p99 %u max %u\n",
+               o->commit_to_present_us[0], o->commit_to_present_us[2], o->commit_to_present_us[3]);
+        printf("core    input to photon us:        p50 %u p99 %u max %u\n",
+               o->input_to_photon_us[0], o->input_to_photon_us[2], o->input_to_photon_us[3]);
+    }
+
+    free(seen_us);
+    munmap(canvas, LAT_W * LAT_H * 4);
+    close(g_sock);
+    return 0;
+}
@@ -0,0 +1,428 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_mt_replay.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "protocol.h"
+#include "shm_helper.h"
+#include "jw_record.h"
+
+/**
+ * Drives a core with a capture made by `jw_mt_core --record FILE`.
+ *
+ * Each recorded client gets its own connection, messages go out in recorded
+ * order and every reply is awaited, like the original clients did. Canvas
+ * contents are restored before each COMMIT. Commands that came through
+ * JW_CMD_BULK are recorded whole and go back through a bulk region of ours. Ids handed out by the core are
+ * only the same as in the capture on a freshly started core. Messages are
+ * recorded without their checksum or CRC and sealed again on the way out, in
+ * the mode the client had switched to with JW_CMD_SET_INTEGRITY.
+ */
+
+#define MAX_CLIENTS 256 // one per possible record client slot
+#define MAX_CANVASES 16
+#define REPLY_TIMEOUT_MS 2000
+
+typedef struct {
+    int sock;               // -1 while not connected
+    int pending_fd;         // JW_REC_FD_DATA, goes out with the next message
+    uint8_t integrity;      // JW_INTEGRITY_*, both ways
+    uint8_t rx[JW_MSG_MAX_LEN * 2]; // replies and events share the stream
+    size_t rx_len;
+    uint8_t *bulk;          // attached bulk region, grown on demand
+    size_t bulk_size;
+} replay_client_t;
+
+typedef struct {
+    int display_id;
+    uint8_t *shadow;        // decoded capture, deltas apply here
+    size_t size;
+    uint8_t *mapped;        // the core's canvas, from the CREATE_CANVAS reply
+    size_t mapped_size;
+} replay_canvas_t;
+
+static replay_client_t g_clients[MAX_CLIENTS];
+static replay_canvas_t g_canvases[MAX_CANVASES];
+static int g_canvas_count = 0;
+
+static double *g_frame_ms = NULL;
+static int g_frame_count = 0;
+static int g_frame_cap = 0;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static replay_canvas_t *find_canvas(int display_id, bool create) {
+    for (int i = 0; i < g_canvas_count; i++) {
+        if (g_canvases[i].display_id == display_id) return &g_canvases[i];
+    }
+    if (!create || g_canvas_count == MAX_CANVASES) return NULL;
+    replay_canvas_t *c = &g_canvases[g_canvas_count++];
+    memset(c, 0, sizeof(*c));
+    c->display_id = display_id;
+    return c;
+}
+
+static int connect_core(void) {
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock == -1) return -1;
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, JW_MT_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        close(sock);
+        return -1;
+    }
+    struct timeval tv = { REPLY_TIMEOUT_MS / 1000, (REPLY_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return sock;
+}
+
+static int fd_from_data(const uint8_t *data, size_t len) {
+    int fd = shm_create_anon("replay", len);
+    if (fd == -1) return -1;
+    void *p = mmap(0, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+    memcpy(p, data, len);
+    munmap(p, len);
+    return fd;
+}
+
+// The reply to msg_id into out, events on the way are dropped. -1 if none came.
+static ssize_t wait_reply(replay_client_t *c, uint16_t msg_id, uint8_t *out, int *fd) {
+    for (;;) {
+        while (c->rx_len >= sizeof(jw_msg_header_t)) {
+            const jw_msg_header_t *hdr = (const jw_msg_header_t*)c->rx;
+            if (hdr->len < sizeof(jw_msg_header_t) || hdr->len > JW_MSG_MAX_LEN) {
+                c->rx_len = 0;
+                return -1;
+            }
+            if (c->rx_len < hdr->len) break;
+            size_t len = hdr->len;
+            bool match = hdr->type == JW_MSG_TYPE_RESP && hdr->msg_id == msg_id;
+            if (match) memcpy(out, c->rx, len);
+            memmove(c->rx, c->rx + len, c->rx_len - len);
+            c->rx_len -= len;
+            if (match) {
+                size_t opened = jw_msg_open(out, len, c->integrity);
+                if (!opened) fprintf(stderr, "reply to msg %u fails its %s\n", msg_id,
+                                     c->integrity == JW_INTEGRITY_CRC32C ? "CRC32C" : "checksum");
+                return opened ? (ssize_t)opened : -1;
+            }
+        }
+        int passed = -1;
+        ssize_t n = recv_msg_fd(c->sock, c->rx + c->rx_len, sizeof(c->rx) - c->rx_len, &passed);
+        if (n <= 0) return -1;
+        if (passed >= 0) {
+            if (*fd < 0) *fd = passed;
+            else close(passed);
+        }
+        c->rx_len += (size_t)n;
+    }
+}
+
+static void send_small(replay_client_t *c, uint8_t cmd, uint16_t msg_id, const void *payload, size_t len, int fd) {
+    uint8_t buf[64 + JW_CRC_LEN];
+    jw_msg_header_t *hdr = (jw_msg_header_t*)buf;
+    hdr->type = JW_MSG_TYPE_CMD;
+    hdr->cmd = cmd;
+    hdr->msg_id = msg_id;
+    hdr->len = (uint16_t)(sizeof(jw_msg_header_t) + len);
+    memcpy(buf + sizeof(jw_msg_header_t), payload, len);
+    send_msg_fd(c->sock, buf, jw_msg_seal(buf, hdr->len, c->integrity), fd);
+}
+
+static void drop_bulk(replay_client_t *c) {
+    if (c->bulk) munmap(c->bulk, c->bulk_size);
+    c->bulk = NULL;
+    c->bulk_size = 0;
+}
+
+// A command too big for the socket goes out as JW_CMD_BULK, attaching a
+// large enough region first
+static int send_bulk(replay_client_t *c, const uint8_t *msg, size_t len) {
+    if (len > c->bulk_size) {
+        drop_bulk(c);
+        if (len > JW_BULK_MAX_SIZE) return -1;
+        int fd = shm_create_anon("replay_bulk", len);
+        if (fd == -1) return -1;
+        shm_seal(fd, true); // the core wants it unshrinkable
+        void *p = mmap(0, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        jw_payload_bulk_attach_t attach = { (uint32_t)len };
+        send_small(c, JW_CMD_BULK_ATTACH, 0, &attach, sizeof(attach), fd);
+        close(fd);
+
+        uint8_t reply[256];
+        int reply_fd = -1;
+        ssize_t n = wait_reply(c, 0, reply, &reply_fd);
+        if (reply_fd >= 0) close(reply_fd);
+        bool ok = n >= (ssize_t)(sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t)) &&
+                  ((const jw_payload_response_t*)(reply + sizeof(jw_msg_header_t)))->status == 0;
+        if (p == MAP_FAILED || !ok) {
+            if (p != MAP_FAILED) munmap(p, len);
+            return -1;
+        }
+        c->bulk = (uint8_t*)p;
+        c->bulk_size = len;
+    }
+
+    memcpy(c->bulk, msg, len);
+    jw_payload_bulk_t bulk = { 0, (uint32_t)len };
+    send_small(c, JW_CMD_BULK, ((const jw_msg_header_t*)msg)->msg_id, &bulk, sizeof(bulk), c->pending_fd);
+    return 0;
+}
+
+static bool is_frame(const uint8_t *msg, size_t len) {
+    const jw_msg_header_t *hdr = (const jw_msg_header_t*)msg;
+    const uint8_t *payload = msg + sizeof(jw_msg_header_t);
+    switch (hdr->cmd) {
+        case JW_CMD_COMMIT:
+            return true;
+        case JW_CMD_DRAW:
+            return len >= sizeof(jw_msg_header_t) + sizeof(jw_payload_draw_t) &&
+                   (((const jw_payload_draw_t*)payload)->flags & JW_DRAW_LIST_COMMIT);
+        case JW_CMD_TRANSACTION:
+            return len >= sizeof(jw_msg_header_t) + sizeof(jw_payload_transaction_t) &&
+                   (((const jw_payload_transaction_t*)payload)->flags & JW_TXN_PRESENT);
+        default:
+            return false;
+    }
+}
+
+static void add_frame(double ms) {
+    if (g_frame_count == g_frame_cap) {
+        int cap = g_frame_cap ? g_frame_cap * 2 : 256;
+        double *grown = (double*)realloc(g_frame_ms, cap * sizeof(double));
+        if (!grown) return;
+        g_frame_ms = grown;
+        g_frame_cap = cap;
+    }
+    g_frame_ms[g_frame_count++] = ms;
+}
+
+// Send one recorded message and wait for its reply
+static void replay_message(int client, const uint8_t *msg, size_t len, bool verbose) {
+    replay_client_t *c = &g_clients[client];
+    if (c->sock < 0 || len < sizeof(jw_msg_header_t)) return;
+    const jw_msg_header_t *hdr = (const jw_msg_header_t*)msg;
+
+    // The core only takes resource memory that cannot change under it, and
+    // capture memory that cannot shrink
+    if (c->pending_fd >= 0 && hdr->cmd == JW_CMD_UPLOAD_RESOURCE) shm_seal(c->pending_fd, false);
+    if (c->pending_fd >= 0 && hdr->cmd == JW_CMD_CAPTURE) shm_seal(c->pending_fd, true);
+
+    uint64_t t0 = now_ns();
+    bool sent = true;
+    size_t crc = c->integrity == JW_INTEGRITY_CRC32C ? JW_CRC_LEN : 0;
+    if (len + crc <= JW_MSG_MAX_LEN) {
+        static uint8_t out[JW_MSG_MAX_LEN];
+        memcpy(out, msg, len);
+        send_msg_fd(c->sock, out, jw_msg_seal(out, len, c->integrity), c->pending_fd);
+    } else {
+        sent = send_bulk(c, msg, len) == 0;
+    }
+    if (c->pending_fd >= 0) {
+        close(c->pending_fd);
+        c->pending_fd = -1;
+    }
+    if (!sent) {
+        fprintf(stderr, "client %d: cannot send %zu byte cmd 0x%02x\n", client, len, hdr->cmd);
+        return;
+    }
+
+    static uint8_t reply[JW_MSG_MAX_LEN];
+    int reply_fd = -1;
+    ssize_t n = wait_reply(c, hdr->msg_id, reply, &reply_fd);
+    double ms = (now_ns() - t0) / 1e6;
+    if (n <= 0) {
+        fprintf(stderr, "client %d: no reply to cmd 0x%02x (msg %u)\n", client, hdr->cmd, hdr->msg_id);
+        return;
+    }
+
+    // Everything after the reply goes both ways in the new mode
+    if (hdr->cmd == JW_CMD_SET_INTEGRITY && (size_t)n >= sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t)) {
+        const jw_payload_response_t *resp = (const jw_payload_response_t*)(reply + sizeof(jw_msg_header_t));
+        if (resp->status == 0) c->integrity = (uint8_t)resp->data.new_id;
+    }
+
+    // Map the new canvas so captures can be restored into it
+    int canvas_display = 0;
+    if (hdr->cmd == JW_CMD_CREATE_CANVAS && len >= sizeof(jw_msg_header_t) + sizeof(jw_payload_create_canvas_t)) {
+        canvas_display = ((const jw_payload_create_canvas_t*)(msg + sizeof(jw_msg_header_t)))->display_id;
+    } else if (hdr->cmd == JW_CMD_CREATE_SURFACE && (size_t)n >= sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t)) {
+        canvas_display = ((const jw_payload_response_t*)(reply + sizeof(jw_msg_header_t)))->data.new_id;
+    }
+    if (canvas_display > 0 && reply_fd >= 0) {
+        replay_canvas_t *canvas = find_canvas(canvas_display, true);
+        struct stat st;
+        if (canvas && fstat(reply_fd, &st) == 0 && st.st_size > 0) {
+            if (canvas->mapped) munmap(canvas->mapped, canvas->mapped_size);
+            canvas->mapped = mmap(0, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, reply_fd, 0);
+            canvas->mapped_size = canvas->mapped == MAP_FAILED ? 0 : (size_t)st.st_size;
+            if (canvas->mapped == MAP_FAILED) canvas->mapped = NULL;
+        }
+    }
+    if (reply_fd >= 0) close(reply_fd);
+
+    if (is_frame(msg, len)) {
+        add_frame(ms);
+        if (verbose) printf("frame %d client %d cmd 0x%02x %.3f ms\n", g_frame_count, client, hdr->cmd, ms);
+    }
+}
+
+static void replay_canvas(const uint8_t *payload, size_t len) {
+    if (len < sizeof(jw_record_canvas_t)) return;
+    const jw_record_canvas_t *head = (const jw_record_canvas_t*)payload;
+    replay_canvas_t *canvas = find_canvas(head->display_id, true);
+    if (!canvas) return;
+
+    if (canvas->size != head->size) {
+        free(canvas->shadow);
+        canvas->shadow = (uint8_t*)calloc(1, head->size);
+        canvas->size = canvas->shadow ? head->size : 0;
+        if (!canvas->shadow) return;
+    }
+    if (jw_record_apply_delta(canvas->shadow, canvas->size, payload + sizeof(*head), len - sizeof(*head)) != 0) {
+        fprintf(stderr, "bad canvas delta for display %d\n", head->display_id);
+        return;
+    }
+    if (canvas->mapped) {
+        memcpy(canvas->mapped, canvas->shadow, canvas->size < canvas->mapped_size ? canvas->size : canvas->mapped_size);
+    }
+}
+
+static int compare_ms(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void report(double wall_ms) {
+    if (g_frame_count == 0) {
+        printf("No frames replayed\n");
+        return;
+    }
+    double sum = 0;
+    for (int i = 0; i < g_frame_count; i++) sum += g_frame_ms[i];
+    qsort(g_frame_ms, g_frame_count, sizeof(double), compare_ms);
+    printf("%d frames in %.1f ms: min %.3f avg %.3f p50 %.3f p99 %.3f max %.3f ms\n",
+           g_frame_count, wall_ms, g_frame_ms[0], sum / g_frame_count,
+           g_frame_ms[g_frame_count / 2], g_frame_ms[(int)(g_frame_count * 0.99)],
+           g_frame_ms[g_frame_count - 1]);
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    bool fast = false;
+    bool verbose = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fast") == 0) fast = true;
+        else if (strcmp(argv[i], "--quiet") == 0) verbose = false;
+        else if (!path && argv[i][0] != '-') path = argv[i];
+        else path = NULL, i = argc;
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s FILE [--fast] [--quiet]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror("open");
+        return 1;
+    }
+    if (jw_record_check_header(f) != 0) {
+        fprintf(stderr, "%s is not a jw_mt_core recording\n", path);
+        return 1;
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        g_clients[i].sock = -1;
+        g_clients[i].pending_fd = -1;
+    }
+
+    jw_record_hdr_t hdr;
+    uint8_t *payload = NULL;
+    size_t cap = 0;
+    uint64_t start = now_ns();
+    int ret;
+    while ((ret = jw_record_read(f, &hdr, &payload, &cap)) > 0) {
+        replay_client_t *c = &g_clients[hdr.client];
+
+        // Original pacing: wait until the record is due
+        if (!fast) {
+            uint64_t due = start + hdr.time_ns;
+            uint64_t now = now_ns();
+            if (due > now) {
+                struct timespec ts = { (time_t)((due - now) / 1000000000ull), (long)((due - now) % 1000000000ull) };
+                while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+            }
+        }
+
+        switch (hdr.kind) {
+            case JW_REC_CONNECT:
+                if (c->sock >= 0) close(c->sock);
+                c->sock = connect_core();
+                c->rx_len = 0;
+                c->integrity = JW_INTEGRITY_CHECKSUM;
+                drop_bulk(c);
+                if (c->sock < 0) {
+                    perror("connect");
+                    return 1;
+                }
+                break;
+            case JW_REC_DISCONNECT:
+                if (c->sock >= 0) close(c->sock);
+                c->sock = -1;
+                drop_bulk(c);
+                break;
+            case JW_REC_FD_DATA:
+                if (c->pending_fd >= 0) close(c->pending_fd);
+                c->pending_fd = fd_from_data(payload, hdr.len);
+                break;
+            case JW_REC_CANVAS:
+                replay_canvas(payload, hdr.len);
+                break;
+            case JW_REC_MESSAGE:
+                replay_message(hdr.client, payload, hdr.len, verbose);
+                break;
+            default:
+                break;
+        }
+    }
+    if (ret < 0) fprintf(stderr, "Recording ends early (truncated?)\n");
+
+    report((now_ns() - start) / 1e6);
+
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (g_clients[i].sock >= 0) close(g_clients[i].sock);
+        if (g_clients[i].pending_fd >= 0) close(g_clients[i].pending_fd);
+    }
+    free(payload);
+    fclose(f);
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_mt_stats.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stdbool.h>
+#include "protocol.h"
+
+// Prints JW_CMD_STATS of a running jw_mt_core, once or every --watch MS
+
+static void print_stats(const uint8_t *data, size_t len) {
+    if (len < sizeof(jw_stats_reply_t)) return;
+    const jw_stats_reply_t *reply = (const jw_stats_reply_t*)data;
+    size_t need = sizeof(jw_stats_reply_t) + reply->client_count * sizeof(jw_stats_client_t) +
+                  reply->output_count * sizeof(jw_stats_output_t);
+    if (len < need) {
+        fprintf(stderr, "Short stats report\n");
+        return;
+    }
+
+    printf("uptime %.1f s\n", reply->uptime_ms / 1000.0);
+    if (reply->huge_bytes || reply->locked_bytes || reply->alloc_fallbacks) {
+        printf("  pixel memory now: %llu KB on huge pages, %llu KB locked; %u fallbacks\n",
+               (unsigned long long)(reply->huge_bytes / 1024), (unsigned long long)(reply->locked_bytes / 1024),
+               reply->alloc_fallbacks);
+    }
+    const jw_stats_client_t *c = (const jw_stats_client_t*)(data + sizeof(jw_stats_reply_t));
+    for (int i = 0; i < reply->client_count; i++, c++) {
+        static const char *prio[] = { "background", "normal", "interactive" };
+        printf("  client %d%s, %s: %u commits (%u/s), uploaded %llu KB, shm %llu KB, queued %u B, "
+               "latency us p50 %u p90 %u p99 %u max %u, throttled %u frames\n",
+               c->slot, (c->flags & JW_STATS_F_SELF) ? " (self)" : "",
+               c->priority < JW_PRIO_COUNT ? prio[c->priority] : "?", c->commits, c->commit_rate,
+               (unsigned long long)(c->bytes_uploaded / 1024), (unsigned long long)(c->shm_bytes / 1024),
+               c->queued_bytes, c->latency_us[0], c->latency_us[1], c->latency_us[2], c->latency_us[3],
+               c->throttled);
+    }
+    const jw_stats_output_t *o = (const jw_stats_output_t*)c;
+    for (int i = 0; i < reply->output_count; i++, o++) {
+        printf("  display %d (%ux%u): %u frames, %u missed vsyncs @%u Hz, dirty %.1f%%, "
+               "composite us p50 %u p99 %u max %u, present us p50 %u p99 %u max %u\n",
+               o->display_id, o->w, o->h, o->frames, o->missed_vsyncs, o->refresh_hz, o->dirty_permille / 10.0,
+               o->composite_us[0], o->composite_us[2], o->composite_us[3],
+               o->present_us[0], o->present_us[2], o->present_us[3]);
+        printf("    commit to present us p50 %u p99 %u max %u, input to photon us p50 %u p99 %u max %u\n",
+               o->commit_to_present_us[0], o->commit_to_present_us[2], o->commit_to_present_us[3],
+               o->input_to_photon_us[0], o->input_to_photon_us[2], o->input_to_photon_us[3]);
+        if (o->tile_hash_us[3]) {
+            printf("    tile hash us p50 %u p99 %u max %u\n", o->tile_hash_us[0], o->tile_hash_us[2], o->tile_hash_us[3]);
+        }
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t interval_ms = 0;
+    if (argc == 3 && strcmp(argv[1], "--watch") == 0) {
+        interval_ms = (uint32_t)atoi(argv[2]);
+    } else if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--watch MS]\n", argv[0]);
+        return 1;
+    }
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, JW_MT_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        perror("connect");
+        return 1;
+    }
+
+    uint8_t req_buf[64];
+    jw_msg_header_t *hdr = (jw_msg_header_t*)req_buf;
+    hdr->type = JW_MSG_TYPE_CMD;
+    hdr->cmd = JW_CMD_STATS;
+    hdr->msg_id = 1;
+    hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_stats_t);
+    jw_payload_stats_t *p = (jw_payload_stats_t*)(req_buf + sizeof(jw_msg_header_t));
+    p->interval_ms = interval_ms;
+    req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
+    send(sock, req_buf, hdr->len, 0);
+
+    // Reports may arrive back to back on the stream, split them by header length
+    static uint8_t buffer[JW_MSG_MAX_LEN * 2];
+    size_t have = 0;
+    for (;;) {
+        ssize_t n = recv(sock, buffer + have, sizeof(buffer) - have, 0);
+        if (n <= 0) break;
+        have += (size_t)n;
+
+        while (have >= sizeof(jw_msg_header_t)) {
+            const jw_msg_header_t *msg = (const jw_msg_header_t*)buffer;
+            if (msg->len < sizeof(jw_msg_header_t) || msg->len > JW_MSG_MAX_LEN) {
+                fprintf(stderr, "Bad message length %u\n", msg->len);
+                return 1;
+            }
+            if (have < msg->len) break;
+
+            if (!jw_validate_checksum(buffer, msg->len)) {
+                fprintf(stderr, "Invalid Checksum\n");
+            } else if (msg->type == JW_MSG_TYPE_RESP) {
+                size_t off = sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t);
+                if (msg->len >= off) print_stats(buffer + off, msg->len - off);
+            } else if (msg->type == JW_MSG_TYPE_EVT && msg->cmd == JW_CMD_STATS) {
+                print_stats(buffer + sizeof(jw_msg_header_t), msg->len - sizeof(jw_msg_header_t));
+            }
+
+            size_t used = msg->len;
+            memmove(buffer, buffer + used, have - used);
+            have -= used;
+        }
+        if (interval_ms == 0) break;
+    }
+
+    close(sock);
+    return 0;
+}
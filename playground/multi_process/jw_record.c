@@ -0,0 +1,208 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_record.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "jw_record.h"
+
+#define JW_RECORD_MAX_FD_DATA (64u * 1024 * 1024)
+#define JW_RECORD_MIN_SKIP    32 // shorter unchanged gaps are cheaper inline than as a new run
+
+// Last capture per display, the base for the next delta
+typedef struct jw_record_canvas_state {
+    int display_id;
+    size_t size;
+    uint8_t *prev;
+    struct jw_record_canvas_state *next;
+} jw_record_canvas_state_t;
+
+struct jw_recorder {
+    FILE *file;
+    uint64_t start_ns;
+    jw_record_canvas_state_t *canvases;
+    uint8_t *scratch;        // delta encoding buffer
+    size_t scratch_cap;
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void write_record(jw_recorder_t *rec, int client, uint8_t kind,
+                         const void *head, size_t head_len, const void *body, size_t body_len) {
+    jw_record_hdr_t hdr = {0};
+    hdr.kind = kind;
+    hdr.client = (uint8_t)client;
+    hdr.len = (uint32_t)(head_len + body_len);
+    hdr.time_ns = now_ns() - rec->start_ns;
+    fwrite(&hdr, sizeof(hdr), 1, rec->file);
+    if (head_len) fwrite(head, head_len, 1, rec->file);
+    if (body_len) fwrite(body, body_len, 1, rec->file);
+}
+
+jw_recorder_t *jw_record_open(const char *path) {
+    jw_recorder_t *rec = (jw_recorder_t*)calloc(1, sizeof(jw_recorder_t));
+    if (!rec) return NULL;
+    rec->file = fopen(path, "wb");
+    if (!rec->file) {
+        perror("record open");
+        free(rec);
+        return NULL;
+    }
+    jw_record_file_header_t fh = { JW_RECORD_MAGIC, JW_RECORD_VERSION };
+    fwrite(&fh, sizeof(fh), 1, rec->file);
+    rec->start_ns = now_ns();
+    return rec;
+}
+
+void jw_record_close(jw_recorder_t *rec) {
+    if (!rec) return;
+    while (rec->canvases) {
+        jw_record_canvas_state_t *c = rec->canvases;
+        rec->canvases = c->next;
+        free(c->prev);
+        free(c);
+    }
+    fclose(rec->file);
+    free(rec->scratch);
+    free(rec);
+}
+
+void jw_record_event(jw_recorder_t *rec, int client, uint8_t kind) {
+    if (!rec) return;
+    write_record(rec, client, kind, NULL, 0, NULL, 0);
+    fflush(rec->file);
+}
+
+void jw_record_message(jw_recorder_t *rec, int client, const void *msg, size_t len, int passed_fd) {
+    if (!rec) return;
+
+    struct stat st;
+    if (passed_fd >= 0 && fstat(passed_fd, &st) == 0 && st.st_size > 0 &&
+        (uint64_t)st.st_size <= JW_RECORD_MAX_FD_DATA) {
+        void *data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_SHARED, passed_fd, 0);
+        if (data != MAP_FAILED) {
+            write_record(rec, client, JW_REC_FD_DATA, NULL, 0, data, (size_t)st.st_size);
+            munmap(data, (size_t)st.st_size);
+        }
+    }
+    write_record(rec, client, JW_REC_MESSAGE, NULL, 0, msg, len);
+}
+
+static bool reserve(jw_recorder_t *rec, size_t need) {
+    if (need <= rec->scratch_cap) return true;
+    uint8_t *grown = (uint8_t*)realloc(rec->scratch, need);
+    if (!grown) return false;
+    rec->scratch = grown;
+    rec->scratch_cap = need;
+    return true;
+}
+
+// Delta of cur against prev into rec->scratch, prev is updated to cur
+static size_t encode_delta(jw_recorder_t *rec, uint8_t *prev, const uint8_t *cur, size_t size) {
+    // Worst case: everything changed, one run
+    if (!reserve(rec, size + 8 * (size / JW_RECORD_MIN_SKIP + 2))) return 0;
+
+    uint8_t *out = rec->scratch;
+    size_t i = 0;
+    while (i < size) {
+        size_t skip_start = i;
+        while (i < size && prev[i] == cur[i]) i++;
+        if (i == size) break; // unchanged tail needs no run
+
+        // Changed span ends at the next unchanged gap long enough to be worth a run
+        size_t lit_start = i;
+        size_t same = 0;
+        while (i < size && same < JW_RECORD_MIN_SKIP) {
+            same = prev[i] == cur[i] ? same + 1 : 0;
+            i++;
+        }
+        size_t lit_end = i - same;
+
+        uint32_t skip = (uint32_t)(lit_start - skip_start);
+        uint32_t count = (uint32_t)(lit_end - lit_start);
+        memcpy(out, &skip, 4);
+        memcpy(out + 4, &count, 4);
+        memcpy(out + 8, cur + lit_start, count);
+        memcpy(prev + lit_start, cur + lit_start, count);
+        out += 8 + count;
+        i = lit_end;
+    }
+    return (size_t)(out - rec->scratch);
+}
+
+void jw_record_canvas(jw_recorder_t *rec, int client, int display_id, const void *pixels, size_t size) {
+    if (!rec || !pixels) return;
+
+    jw_record_canvas_state_t *c = rec->canvases;
+    while (c && c->display_id != display_id) c = c->next;
+    if (!c) {
+        c = (jw_record_canvas_state_t*)calloc(1, sizeof(jw_record_canvas_state_t));
+        if (!c) return;
+        c->display_id = display_id;
+        c->next = rec->canvases;
+        rec->canvases = c;
+    }
+    if (c->size != size) {
+        free(c->prev);
+        c->prev = (uint8_t*)calloc(1, size);
+        c->size = c->prev ? size : 0;
+        if (!c->prev) return;
+    }
+
+    size_t len = encode_delta(rec, c->prev, (const uint8_t*)pixels, size);
+    jw_record_canvas_t head = { display_id, (uint32_t)size };
+    write_record(rec, client, JW_REC_CANVAS, &head, sizeof(head), rec->scratch, len);
+}
+
+int jw_record_check_header(FILE *f) {
+    jw_record_file_header_t fh;
+    if (fread(&fh, sizeof(fh), 1, f) != 1) return -1;
+    if (memcmp(fh.magic, JW_RECORD_MAGIC, sizeof(fh.magic)) != 0 || fh.version != JW_RECORD_VERSION) return -1;
+    return 0;
+}
+
+int jw_record_read(FILE *f, jw_record_hdr_t *hdr, uint8_t **payload, size_t *cap) {
+    if (fread(hdr, sizeof(*hdr), 1, f) != 1) return feof(f) ? 0 : -1;
+    if (hdr->len > *cap) {
+        uint8_t *grown = (uint8_t*)realloc(*payload, hdr->len);
+        if (!grown) return -1;
+        *payload = grown;
+        *cap = hdr->len;
+    }
+    if (hdr->len && fread(*payload, hdr->len, 1, f) != 1) return -1; // truncated, e.g. core killed mid-write
+    return 1;
+}
+
+int jw_record_apply_delta(uint8_t *pixels, size_t size, const uint8_t *delta, size_t len) {
+    size_t pos = 0;
+    while (len >= 8) {
+        uint32_t skip, count;
+        memcpy(&skip, delta, 4);
+        memcpy(&count, delta + 4, 4);
+        if (count > len - 8 || pos + skip + count > size) return -1;
+        pos += skip;
+        memcpy(pixels + pos, delta + 8, count);
+        pos += count;
+        delta += 8 + count;
+        len -= 8 + count;
+    }
+    return len == 0 ? 0 : -1;
+}
@@ -0,0 +1,92 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_record.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_RECORD_H
+#define JW_MT_RECORD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Capture of everything clients send to jw_mt_core, for jw_mt_replay.
+ *
+ * File: jw_record_file_header_t, then a stream of jw_record_hdr_t each followed
+ * by `len` payload bytes. Records of one client come in the order it sent them:
+ * JW_REC_FD_DATA precedes the message the fd came with, JW_REC_CANVAS precedes
+ * the COMMIT it was captured for.
+ */
+
+#define JW_RECORD_MAGIC   "JWREC"
+#define JW_RECORD_VERSION 2 // 2: 16-bit draw and transaction counts
+
+typedef struct __attribute__((packed)) {
+    char magic[6];          // JW_RECORD_MAGIC
+    uint16_t version;
+} jw_record_file_header_t;
+
+enum {
+    JW_REC_CONNECT    = 0x01,
+    JW_REC_DISCONNECT = 0x02,
+    JW_REC_MESSAGE    = 0x03, // message bytes as received
+    JW_REC_FD_DATA    = 0x04, // contents of the fd passed with the next message
+    JW_REC_CANVAS     = 0x05  // jw_record_canvas_t + delta against the previous capture
+};
+
+typedef struct __attribute__((packed)) {
+    uint8_t kind;           // JW_REC_*
+    uint8_t client;         // connection slot in the core
+    uint16_t reserved;
+    uint32_t len;           // payload bytes after this header
+    uint64_t time_ns;       // since the recording started
+} jw_record_hdr_t;
+
+_Static_assert(sizeof(jw_record_hdr_t) == 16, "Record header size must be 16 bytes");
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint32_t size;          // canvas bytes, a size change restarts the delta from zeros
+} jw_record_canvas_t;
+
+/*
+ * Canvas delta: runs of { uint32 skip, uint32 count, count bytes } until the
+ * canvas is covered. Skipped bytes are unchanged since the previous capture.
+ */
+
+// Writer, used by the core. All calls are no-ops on a NULL recorder.
+typedef struct jw_recorder jw_recorder_t;
+
+jw_recorder_t *jw_record_open(const char *path);
+void jw_record_close(jw_recorder_t *rec);
+void jw_record_event(jw_recorder_t *rec, int client, uint8_t kind);
+// passed_fd (or -1) is captured as JW_REC_FD_DATA first
+void jw_record_message(jw_recorder_t *rec, int client, const void *msg, size_t len, int passed_fd);
+void jw_record_canvas(jw_recorder_t *rec, int client, int display_id, const void *pixels, size_t size);
+
+// Reader, used by jw_mt_replay. Returns 1 per record, 0 at the end, -1 on error.
+// *payload is grown as needed and owned by the caller.
+int jw_record_check_header(FILE *f);
+int jw_record_read(FILE *f, jw_record_hdr_t *hdr, uint8_t **payload, size_t *cap);
+
+// Apply a JW_REC_CANVAS delta (after its jw_record_canvas_t) to `pixels`
+int jw_record_apply_delta(uint8_t *pixels, size_t size, const uint8_t *delta, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_RECORD_H
@@ -0,0 +1,79 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_region.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#include "jw_region.h"
+
+// Split r around the overlap `o` into up to 4 bands: above, below, left, right
+static int split_rect(const jw_rect_t *r, const jw_rect_t *o, jw_rect_t out[4]) {
+    int n = 0;
+    if (o->y > r->y) {
+        jw_rect_t top = { r->x, r->y, r->w, o->y - r->y };
+        out[n++] = top;
+    }
+    if (o->y + o->h < r->y + r->h) {
+        jw_rect_t bottom = { r->x, o->y + o->h, r->w, r->y + r->h - (o->y + o->h) };
+        out[n++] = bottom;
+    }
+    if (o->x > r->x) {
+        jw_rect_t left = { r->x, o->y, o->x - r->x, o->h };
+        out[n++] = left;
+    }
+    if (o->x + o->w < r->x + r->w) {
+        jw_rect_t right = { o->x + o->w, o->y, r->x + r->w - (o->x + o->w), o->h };
+        out[n++] = right;
+    }
+    return n;
+}
+
+void jw_region_subtract(jw_region_t *region, const jw_rect_t *hole) {
+    if (jw_rect_empty(hole)) return;
+
+    jw_region_t result = { 0 };
+    for (int i = 0; i < region->count; i++) {
+        const jw_rect_t *r = &region->rects[i];
+        jw_rect_t pieces[4];
+        jw_rect_t o;
+        int n;
+        if (jw_rect_intersect(r, hole, &o)) {
+            n = split_rect(r, &o, pieces);
+        } else {
+            pieces[0] = *r;
+            n = 1;
+        }
+        // Out of room: keep the region as it was, rects must never overlap
+        if (result.count + n > JW_REGION_MAX_RECTS) return;
+        for (int k = 0; k < n; k++) {
+            result.rects[result.count++] = pieces[k];
+        }
+    }
+    *region = result;
+}
+
+void jw_region_add(jw_region_t *region, const jw_rect_t *rect) {
+    if (jw_rect_empty(rect)) return;
+
+    // Only the part of rect outside the region is new
+    jw_region_t extra;
+    jw_region_visible(&extra, rect, region);
+    for (int i = 0; i < extra.count; i++) {
+        if (region->count == JW_REGION_MAX_RECTS) return; // smaller cover only costs culling
+        region->rects[region->count++] = extra.rects[i];
+    }
+}
+
+void jw_region_visible(jw_region_t *out, const jw_rect_t *rect, const jw_region_t *cover) {
+    jw_region_init(out, rect);
+    for (int i = 0; i < cover->count && !jw_region_empty(out); i++) {
+        jw_region_subtract(out, &cover->rects[i]);
+    }
+}
@@ -0,0 +1,59 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_region.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_REGION_H
+#define JW_MT_REGION_H
+
+#include "jw_accel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JW_REGION_MAX_RECTS 16
+
+/**
+ * Small set of non-overlapping rects.
+ *
+ * Used for visibility during composition. When an operation would need more
+ * than JW_REGION_MAX_RECTS the region stays larger than exact, never smaller,
+ * so callers only lose culling, not pixels.
+ */
+typedef struct jw_region {
+    int count;
+    jw_rect_t rects[JW_REGION_MAX_RECTS];
+} jw_region_t;
+
+static inline void jw_region_init(jw_region_t *region, const jw_rect_t *rect) {
+    region->count = 0;
+    if (rect && !jw_rect_empty(rect)) region->rects[region->count++] = *rect;
+}
+
+static inline bool jw_region_empty(const jw_region_t *region) {
+    return region->count == 0;
+}
+
+// Remove `hole` from the region
+void jw_region_subtract(jw_region_t *region, const jw_rect_t *hole);
+
+// Add `rect`, the parts already covered are not duplicated
+void jw_region_add(jw_region_t *region, const jw_rect_t *rect);
+
+// Region of `rect` not covered by `cover`
+void jw_region_visible(jw_region_t *out, const jw_rect_t *rect, const jw_region_t *cover);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_REGION_H
@@ -0,0 +1,238 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_resource.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include "jw_resource.h"
+#include "jw_mem.h"
+
+#define JW_RESOURCE_ROW_ALIGN 64
+
+#ifdef F_GET_SEALS
+#define JW_RESOURCE_SEALS (F_SEAL_SHRINK | F_SEAL_WRITE)
+#endif
+
+static size_t resident_size(const jw_resource_t *res) {
+    return (size_t)res->resident.stride * res->resident.h;
+}
+
+static void evict(jw_resource_cache_t *cache, jw_resource_t *res) {
+    if (!res->resident.pixels) return;
+    jw_mem_free(res->resident.pixels, resident_size(res));
+    res->resident.pixels = NULL;
+    cache->used -= resident_size(res);
+}
+
+// Drop least recently used resources until `need` more bytes fit the budget
+static void make_room(jw_resource_cache_t *cache, size_t need) {
+    while (cache->used + need > cache->budget) {
+        jw_resource_t *victim = NULL;
+        for (jw_resource_t *r = cache->list; r; r = r->next) {
+            if (!r->resident.pixels || r->pins > 0 || r->fd < 0) continue;
+            if (!victim || r->last_use < victim->last_use) victim = r;
+        }
+        if (!victim) return; // everything left is in use
+        evict(cache, victim);
+    }
+}
+
+static int load(jw_resource_cache_t *cache, jw_resource_t *res) {
+    size_t src_size = (size_t)res->stride * res->h;
+    size_t row_bytes = (size_t)res->w * jw_format_bpp(res->format);
+    int stride = (int)((row_bytes + JW_RESOURCE_ROW_ALIGN - 1) & ~(size_t)(JW_RESOURCE_ROW_ALIGN - 1));
+
+    res->resident.w = res->w;
+    res->resident.h = res->h;
+    res->resident.stride = stride;
+    res->resident.format = res->format;
+    make_room(cache, resident_size(res));
+
+    void *pixels = jw_mem_alloc(resident_size(res)); // aligned to JW_RESOURCE_ROW_ALIGN
+    if (!pixels) return -1;
+
+    uint8_t *src = (uint8_t*)mmap(0, src_size, PROT_READ, MAP_SHARED, res->fd, 0);
+    if (src == MAP_FAILED) {
+        perror("resource mmap");
+        jw_mem_free(pixels, resident_size(res));
+        return -1;
+    }
+    for (int y = 0; y < res->h; y++) {
+        memcpy((uint8_t*)pixels + (size_t)y * stride, src + (size_t)y * res->stride, row_bytes);
+    }
+    munmap(src, src_size);
+
+    res->resident.pixels = pixels;
+    cache->used += resident_size(res);
+    return 0;
+}
+
+static jw_resource_t *find(jw_resource_cache_t *cache, uint32_t id) {
+    for (jw_resource_t *r = cache->list; r; r = r->next) {
+        if (r->id == id) return r;
+    }
+    return NULL;
+}
+
+static void destroy(jw_resource_cache_t *cache, jw_resource_t *res) {
+    evict(cache, res);
+    if (res->fd >= 0) close(res->fd);
+    free(res);
+}
+
+// A pinned resource stays alive off the list until its last release
+static void unlink_and_destroy(jw_resource_cache_t *cache, jw_resource_t **link) {
+    jw_resource_t *res = *link;
+    *link = res->next;
+    if (res->pins > 0) {
+        res->dead = true;
+    } else {
+        destroy(cache, res);
+    }
+}
+
+void jw_resource_cache_init(jw_resource_cache_t *cache, size_t budget) {
+    memset(cache, 0, sizeof(*cache));
+    cache->budget = budget;
+    cache->next_id = 1;
+    pthread_mutex_init(&cache->lock, NULL);
+}
+
+void jw_resource_cache_deinit(jw_resource_cache_t *cache) {
+    while (cache->list) {
+        unlink_and_destroy(cache, &cache->list);
+    }
+    pthread_mutex_destroy(&cache->lock);
+}
+
+int jw_resource_create(jw_resource_cache_t *cache, int owner, int fd, int w, int h, int stride, jw_format_t format) {
+    if (fd < 0 || w <= 0 || h <= 0 || format >= JW_FORMAT_COUNT || stride < w * jw_format_bpp(format)) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)stride * h) {
+        fprintf(stderr, "resource fd too small for %dx%d (stride %d)\n", w, h, stride);
+        return -1;
+    }
+#ifdef JW_RESOURCE_SEALS
+    // Unsealed, the client could rewrite or truncate it under a reload
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals == -1 || (seals & JW_RESOURCE_SEALS) != JW_RESOURCE_SEALS) {
+        fprintf(stderr, "resource fd not sealed against writes and shrinking\n");
+        return -1;
+    }
+#endif
+
+    jw_resource_t *res = (jw_resource_t*)calloc(1, sizeof(jw_resource_t));
+    if (!res) return -1;
+    pthread_mutex_lock(&cache->lock);
+    res->id = cache->next_id++;
+    res->owner = owner;
+    res->fd = fd;
+    res->w = w;
+    res->h = h;
+    res->stride = stride;
+    res->format = format;
+    res->last_use = __atomic_load_n(&cache->frame, __ATOMIC_RELAXED);
+
+    // Load eagerly, the upload is the natural moment to pay for the copy
+    int id = -1;
+    if (load(cache, res) == 0) {
+#ifndef JW_RESOURCE_SEALS
+        // Nothing holds the client to its pixels, this copy is all we trust
+        close(res->fd);
+        res->fd = -1;
+#endif
+        res->next = cache->list;
+        cache->list = res;
+        id = (int)res->id;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (id < 0) free(res);
+    return id;
+}
+
+int jw_resource_free(jw_resource_cache_t *cache, uint32_t id, int owner) {
+    int ret = -1;
+    pthread_mutex_lock(&cache->lock);
+    for (jw_resource_t **link = &cache->list; *link; link = &(*link)->next) {
+        if ((*link)->id == id) {
+            if ((*link)->owner == owner) {
+                unlink_and_destroy(cache, link);
+                ret = 0;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return ret;
+}
+
+void jw_resource_free_owner(jw_resource_cache_t *cache, int owner) {
+    pthread_mutex_lock(&cache->lock);
+    jw_resource_t **link = &cache->list;
+    while (*link) {
+        if ((*link)->owner == owner) {
+            unlink_and_destroy(cache, link);
+        } else {
+            link = &(*link)->next;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+size_t jw_resource_owner_bytes(jw_resource_cache_t *cache, int owner) {
+    size_t bytes = 0;
+    pthread_mutex_lock(&cache->lock);
+    for (const jw_resource_t *res = cache->list; res; res = res->next) {
+        if (res->owner == owner && res->fd >= 0) bytes += (size_t)res->stride * res->h;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return bytes;
+}
+
+const jw_buffer_t *jw_resource_acquire(jw_resource_cache_t *cache, uint32_t id) {
+    const jw_buffer_t *buf = NULL;
+    pthread_mutex_lock(&cache->lock);
+    jw_resource_t *res = find(cache, id);
+    if (res) {
+        res->last_use = __atomic_load_n(&cache->frame, __ATOMIC_RELAXED);
+        if (res->resident.pixels || load(cache, res) == 0) {
+            res->pins++;
+            buf = &res->resident;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return buf;
+}
+
+int jw_resource_format(jw_resource_cache_t *cache, uint32_t id) {
+    pthread_mutex_lock(&cache->lock);
+    const jw_resource_t *res = find(cache, id);
+    int format = res ? (int)res->format : -1;
+    pthread_mutex_unlock(&cache->lock);
+    return format;
+}
+
+void jw_resource_release(jw_resource_cache_t *cache, const jw_buffer_t *resident) {
+    if (!resident) return;
+    jw_resource_t *res = (jw_resource_t*)((const char*)resident - offsetof(jw_resource_t, resident));
+    pthread_mutex_lock(&cache->lock);
+    if (--res->pins == 0 && res->dead) destroy(cache, res);
+    pthread_mutex_unlock(&cache->lock);
+}
@@ -0,0 +1,90 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_resource.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_RESOURCE_H
+#define JW_MT_RESOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "jw_accel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Server-side cache of immutable pixel resources uploaded by clients.
+ *
+ * A resource keeps the client's fd so that its resident copy (tightly packed,
+ * row aligned for the accelerator) can be dropped under memory pressure and
+ * reloaded on the next use. The fd must be sealed against writes and
+ * shrinking (memfd seals), so a reload reads what was uploaded and cannot
+ * fault. Where the system has no seals the first copy is kept for good and
+ * the fd closed. jw_resource_acquire() pins the resident copy until
+ * the matching jw_resource_release(), pinned copies are never evicted and a
+ * resource freed while pinned goes away on its last release. The cache is
+ * shared by the display render threads, every call takes its lock.
+ */
+
+typedef struct jw_resource {
+    uint32_t id;
+    int owner;              // client socket, resources die with their client
+    int fd;                 // sealed client memory, source for (re)loading; -1 = never evicted
+    int w, h, stride;       // layout of the client memory
+    jw_format_t format;     // kept in the resident copy too
+    jw_buffer_t resident;   // pixels == NULL while evicted
+    uint64_t last_use;      // frame stamp for LRU
+    int pins;               // acquired and not released yet
+    bool dead;              // freed while pinned, off the list
+    struct jw_resource *next;
+} jw_resource_t;
+
+typedef struct jw_resource_cache {
+    jw_resource_t *list;
+    size_t budget;          // bytes of resident pixels allowed
+    size_t used;
+    uint32_t next_id;
+    uint64_t frame;
+    pthread_mutex_t lock;
+} jw_resource_cache_t;
+
+void jw_resource_cache_init(jw_resource_cache_t *cache, size_t budget);
+void jw_resource_cache_deinit(jw_resource_cache_t *cache);
+
+// Takes ownership of fd on success. Returns the new handle (>0) or -1.
+int jw_resource_create(jw_resource_cache_t *cache, int owner, int fd, int w, int h, int stride, jw_format_t format);
+int jw_resource_free(jw_resource_cache_t *cache, uint32_t id, int owner);
+void jw_resource_free_owner(jw_resource_cache_t *cache, int owner);
+
+// Client memory held for an owner's resources (the fds, not resident copies)
+size_t jw_resource_owner_bytes(jw_resource_cache_t *cache, int owner);
+
+// Resident pixels for a handle, loading them back if evicted. NULL if unknown.
+// Pinned until jw_resource_release() with the same pointer.
+const jw_buffer_t *jw_resource_acquire(jw_resource_cache_t *cache, uint32_t id);
+void jw_resource_release(jw_resource_cache_t *cache, const jw_buffer_t *resident);
+
+// Format of a handle without pinning or loading it, -1 if unknown
+int jw_resource_format(jw_resource_cache_t *cache, uint32_t id);
+
+// Start a new frame, the LRU clock for eviction
+static inline void jw_resource_frame_begin(jw_resource_cache_t *cache) {
+    __atomic_fetch_add(&cache->frame, 1, __ATOMIC_RELAXED);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_RESOURCE_H
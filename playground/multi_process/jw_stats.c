@@ -0,0 +1,61 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_stats.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#include <stdbool.h>
+#include "jw_stats.h"
+
+static int bucket_of(uint32_t v) {
+    if (v < JW_HIST_SUB) return (int)v;
+    int shift = 31 - __builtin_clz(v) - JW_HIST_SUB_BITS;
+    return (shift + 1) * JW_HIST_SUB + (int)(v >> shift) - JW_HIST_SUB;
+}
+
+static uint32_t bucket_top(int b) {
+    if (b < JW_HIST_SUB) return (uint32_t)b;
+    int shift = b / JW_HIST_SUB - 1;
+    uint64_t top = ((uint64_t)(b % JW_HIST_SUB + JW_HIST_SUB + 1) << shift) - 1;
+    return top > UINT32_MAX ? UINT32_MAX : (uint32_t)top;
+}
+
+void jw_hist_add(jw_histogram_t *hist, uint32_t us) {
+    __atomic_fetch_add(&hist->counts[bucket_of(us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->total, 1, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&hist->max, &max, us, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+uint32_t jw_hist_percentile(const jw_histogram_t *hist, int permille) {
+    uint64_t total = __atomic_load_n(&hist->total, __ATOMIC_RELAXED);
+    if (total == 0) return 0;
+    uint64_t rank = (total * (uint64_t)permille + 999) / 1000;
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    uint64_t max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+    for (int b = 0; b < JW_HIST_BUCKETS; b++) {
+        seen += __atomic_load_n(&hist->counts[b], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            uint32_t top = bucket_top(b);
+            return top < max ? top : (uint32_t)max;
+        }
+    }
+    return (uint32_t)max;
+}
+
+void jw_hist_summary(const jw_histogram_t *hist, uint32_t out[4]) {
+    out[0] = jw_hist_percentile(hist, 500);
+    out[1] = jw_hist_percentile(hist, 900);
+    out[2] = jw_hist_percentile(hist, 990);
+    out[3] = (uint32_t)__atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,92 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_stats.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_STATS_H
+#define JW_MT_STATS_H
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Counters behind JW_CMD_STATS.
+ *
+ * Everything is updated with relaxed atomics and read without a lock, so the
+ * hot path never waits and a report may mix values from neighbouring frames.
+ */
+
+static inline uint64_t jw_stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void jw_stat_add(uint64_t *counter, uint64_t v) {
+    __atomic_fetch_add(counter, v, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t jw_stat_get(const uint64_t *counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+/*
+ * Log-linear histogram of microseconds: each power of two is split into
+ * JW_HIST_SUB linear buckets, so a percentile is within 1/JW_HIST_SUB of the
+ * true value over the full uint32 range.
+ */
+#define JW_HIST_SUB_BITS 3
+#define JW_HIST_SUB      (1 << JW_HIST_SUB_BITS)
+#define JW_HIST_BUCKETS  ((32 - JW_HIST_SUB_BITS + 1) * JW_HIST_SUB)
+
+typedef struct jw_histogram {
+    uint64_t counts[JW_HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} jw_histogram_t;
+
+void jw_hist_add(jw_histogram_t *hist, uint32_t us);
+
+// Upper bound of the bucket holding the permille-th value, 0 when empty
+uint32_t jw_hist_percentile(const jw_histogram_t *hist, int permille);
+
+// p50, p90, p99 and max, the layout of the *_us[4] fields in protocol.h
+void jw_hist_summary(const jw_histogram_t *hist, uint32_t out[4]);
+
+// Per client, reported as jw_stats_client_t
+typedef struct jw_client_counters {
+    uint64_t commits;
+    uint64_t bytes_uploaded;
+    jw_histogram_t latency;     // receive to reply
+} jw_client_counters_t;
+
+// Per output, reported as jw_stats_output_t
+typedef struct jw_output_counters {
+    uint64_t frames;
+    uint64_t missed_vsyncs;
+    uint64_t dirty_px;          // recomposed pixels
+    uint64_t screen_px;         // screen pixels of all frames
+    jw_histogram_t composite;
+    jw_histogram_t present;
+    jw_histogram_t commit_to_present;
+    jw_histogram_t input_to_photon;
+    jw_histogram_t tile_hash;   // --auto-damage, per commit
+} jw_output_counters_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_STATS_H
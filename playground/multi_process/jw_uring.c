@@ -0,0 +1,615 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_uring.c    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#define _GNU_SOURCE
+#include "jw_uring.h"
+
+#if JW_HAVE_IO_URING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "protocol.h"
+
+#define SQ_ENTRIES 256
+#define CQ_ENTRIES 1024
+#define MAX_CONNS 16
+#define MAX_WATCHES 4
+#define BUF_COUNT 64            // provided receive buffers, power of two
+#define BUF_SIZE 16384
+#define BUF_GROUP 1
+#define MAX_PASSED_FDS 8        // per client, received and not handed out yet
+#define MAX_BATCH 16            // messages per sendmsg
+#define MAX_TIMERS 8
+#define RX_LIMIT (4u << 20)     // unread bytes before a client is cut off
+
+// Low bits of user_data: what completed
+enum { TAG_RECV = 1, TAG_SEND, TAG_POLL, TAG_TIMER, TAG_NONE };
+
+typedef struct jw_uring_msg {
+    struct jw_uring_msg *next;
+    int pass_fd;
+    size_t len;
+    uint8_t data[];
+} jw_uring_msg_t;
+
+// One sendmsg in flight, its address is the user_data
+typedef struct jw_uring_batch {
+    int conn;
+    uint32_t gen;
+    struct msghdr msg;
+    struct iovec iov[MAX_BATCH];
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } ctrl;
+    jw_uring_msg_t *msgs;
+} jw_uring_batch_t;
+
+typedef struct {
+    int fd;                     // -1 = free
+    uint32_t gen;               // completions of earlier clients in the slot are stale
+    bool armed;                 // multishot recv live
+    bool eof;
+    uint8_t *rx;
+    size_t rx_len, rx_cap;
+    uint64_t rx_pos;            // stream offset of rx[0]
+    struct { uint64_t pos; int fd; } fds[MAX_PASSED_FDS]; // came with the byte at pos
+    int fd_count;
+    jw_uring_msg_t *tx_head, *tx_tail;
+    bool tx_busy;               // one sendmsg at a time keeps the order
+} jw_uring_conn_t;
+
+typedef struct {
+    int fd;
+    bool armed;
+    bool fired;
+} jw_uring_watch_t;
+
+typedef struct {
+    bool used;
+    uint32_t seq;
+    uint64_t deadline;
+    struct __kernel_timespec ts;
+} jw_uring_timer_t;
+
+struct jw_uring {
+    int fd;
+    void *ring_ptr;
+    size_t ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned sq_entries;
+    unsigned sq_local;          // tail with the SQEs not submitted yet
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    struct io_uring_buf_ring *br;
+    size_t br_size;
+    uint8_t *bufs;
+    struct msghdr recv_hdr;     // multishot recvmsg layout: no name, room for fds
+
+    jw_uring_conn_t conns[MAX_CONNS];
+    jw_uring_watch_t watches[MAX_WATCHES];
+    int watch_count;
+    jw_uring_timer_t timers[MAX_TIMERS];
+    uint32_t timer_seq;
+};
+
+static uint64_t conn_tag(int idx, uint32_t gen) {
+    return (((uint64_t)gen << 8 | (uint64_t)idx) << 3) | TAG_RECV;
+}
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int submit(jw_uring_t *r, unsigned wait) {
+    unsigned n = r->sq_local - *r->sq_tail;
+    __atomic_store_n(r->sq_tail, r->sq_local, __ATOMIC_RELEASE);
+    return (int)syscall(__NR_io_uring_enter, r->fd, n, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+}
+
+static struct io_uring_sqe *get_sqe(jw_uring_t *r) {
+    if (r->sq_local - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) {
+        submit(r, 0);
+        if (r->sq_local - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) return NULL;
+    }
+    unsigned idx = r->sq_local & *r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    r->sq_array[idx] = idx;
+    r->sq_local++;
+    return sqe;
+}
+
+static jw_uring_conn_t *find_conn(jw_uring_t *r, int fd) {
+    for (int i = 0; i < MAX_CONNS; i++) {
+        if (r->conns[i].fd == fd && fd >= 0) return &r->conns[i];
+    }
+    return NULL;
+}
+
+static void recycle(jw_uring_t *r, unsigned bid) {
+    unsigned short tail = r->br->tail;
+    struct io_uring_buf *b = &r->br->bufs[tail & (BUF_COUNT - 1)];
+    b->addr = (uintptr_t)(r->bufs + (size_t)bid * BUF_SIZE);
+    b->len = BUF_SIZE;
+    b->bid = (unsigned short)bid;
+    __atomic_store_n(&r->br->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
+
+static void arm_recv(jw_uring_t *r, int idx) {
+    jw_uring_conn_t *c = &r->conns[idx];
+    struct io_uring_sqe *sqe = get_sqe(r);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = c->fd;
+    sqe->addr = (uintptr_t)&r->recv_hdr;
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = conn_tag(idx, c->gen);
+    c->armed = true;
+}
+
+static void arm_poll(jw_uring_t *r, int idx) {
+    // One-shot: completes at once while still readable, like select() would
+    struct io_uring_sqe *sqe = get_sqe(r);
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = r->watches[idx].fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = ((uint64_t)idx << 3) | TAG_POLL;
+    r->watches[idx].armed = true;
+}
+
+// Wake by deadline unless an armed timer does already. False if none can be armed.
+static bool arm_timer(jw_uring_t *r, uint64_t deadline) {
+    jw_uring_timer_t *free_slot = NULL;
+    for (int i = 0; i < MAX_TIMERS; i++) {
+        jw_uring_timer_t *t = &r->timers[i];
+        if (t->used && t->deadline <= deadline) return true;
+        if (!t->used && !free_slot) free_slot = t;
+    }
+    if (!free_slot) return false;
+    struct io_uring_sqe *sqe = get_sqe(r);
+    if (!sqe) return false;
+
+    free_slot->used = true;
+    free_slot->seq = ++r->timer_seq;
+    free_slot->deadline = deadline;
+    free_slot->ts.tv_sec = (long long)(deadline / 1000000000ull);
+    free_slot->ts.tv_nsec = (long long)(deadline % 1000000000ull);
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (uintptr_t)&free_slot->ts;
+    sqe->len = 1;
+    sqe->timeout_flags = IORING_TIMEOUT_ABS;
+    sqe->user_data = ((uint64_t)free_slot->seq << 3) | TAG_TIMER;
+    return true;
+}
+
+static void free_msgs(jw_uring_msg_t *m) {
+    while (m) {
+        jw_uring_msg_t *next = m->next;
+        if (m->pass_fd >= 0) close(m->pass_fd);
+        free(m);
+        m = next;
+    }
+}
+
+// Everything queued for a client in one sendmsg, a message with an fd on its own
+static void flush(jw_uring_t *r, int idx) {
+    jw_uring_conn_t *c = &r->conns[idx];
+    if (c->tx_busy || !c->tx_head) return;
+    jw_uring_batch_t *b = (jw_uring_batch_t*)calloc(1, sizeof(jw_uring_batch_t));
+    if (!b) return;
+    struct io_uring_sqe *sqe = get_sqe(r);
+    if (!sqe) {
+        free(b);
+        return;
+    }
+
+    int n = 0;
+    jw_uring_msg_t **tail = &b->msgs;
+    while (c->tx_head && n < MAX_BATCH && (n == 0 || c->tx_head->pass_fd < 0)) {
+        jw_uring_msg_t *m = c->tx_head;
+        c->tx_head = m->next;
+        m->next = NULL;
+        *tail = m;
+        tail = &m->next;
+        b->iov[n].iov_base = m->data;
+        b->iov[n].iov_len = m->len;
+        n++;
+        if (m->pass_fd >= 0) break;
+    }
+    if (!c->tx_head) c->tx_tail = NULL;
+
+    b->conn = idx;
+    b->gen = c->gen;
+    b->msg.msg_iov = b->iov;
+    b->msg.msg_iovlen = n;
+    if (b->msgs->pass_fd >= 0) {
+        b->msg.msg_control = b->ctrl.buf;
+        b->msg.msg_controllen = sizeof(b->ctrl.buf);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&b->msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &b->msgs->pass_fd, sizeof(int));
+    }
+
+    // WAITALL: the kernel finishes short stream sends itself
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = c->fd;
+    sqe->addr = (uintptr_t)&b->msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+    sqe->user_data = (uintptr_t)b | TAG_SEND;
+    c->tx_busy = true;
+}
+
+// A receive buffer: payload onto the client's stream, fds noted at its last byte
+static void take(jw_uring_conn_t *c, const uint8_t *buf, size_t len, const struct msghdr *layout) {
+    const struct io_uring_recvmsg_out *out = (const struct io_uring_recvmsg_out*)buf;
+    size_t off = sizeof(*out) + layout->msg_namelen + layout->msg_controllen;
+    if (len < off) return;
+    size_t payload = out->payloadlen < len - off ? out->payloadlen : len - off;
+    if (out->payloadlen == 0) {
+        c->eof = true; // how multishot recvmsg reports the end of a stream
+        return;
+    }
+
+    if (c->rx_len + payload > c->rx_cap) {
+        size_t cap = c->rx_cap ? c->rx_cap : JW_MSG_MAX_LEN;
+        while (cap < c->rx_len + payload) cap *= 2;
+        uint8_t *grown = cap <= RX_LIMIT ? (uint8_t*)realloc(c->rx, cap) : NULL;
+        if (!grown) {
+            c->eof = true; // not reading fast enough, or out of memory: cut it off
+            return;
+        }
+        c->rx = grown;
+        c->rx_cap = cap;
+    }
+    memcpy(c->rx + c->rx_len, buf + off, payload);
+    c->rx_len += payload;
+
+    struct msghdr ctrl = {0};
+    ctrl.msg_control = (void*)(buf + sizeof(*out) + layout->msg_namelen);
+    ctrl.msg_controllen = out->controllen;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&ctrl); cmsg; cmsg = CMSG_NXTHDR(&ctrl, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        int count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < count; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (c->fd_count == MAX_PASSED_FDS || payload == 0) {
+                close(fd);
+                continue;
+            }
+            c->fds[c->fd_count].pos = c->rx_pos + c->rx_len - 1;
+            c->fds[c->fd_count].fd = fd;
+            c->fd_count++;
+        }
+    }
+}
+
+static void on_cqe(jw_uring_t *r, const struct io_uring_cqe *cqe) {
+    uint64_t tag = cqe->user_data & 7;
+    if (tag == TAG_RECV) {
+        int idx = (int)((cqe->user_data >> 3) & 0xFF);
+        uint32_t gen = (uint32_t)(cqe->user_data >> 11);
+        jw_uring_conn_t *c = &r->conns[idx];
+        bool live = c->fd >= 0 && c->gen == gen;
+        if (cqe->flags & IORING_CQE_F_BUFFER) {
+            unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            if (live && cqe->res > 0) take(c, r->bufs + (size_t)bid * BUF_SIZE, (size_t)cqe->res, &r->recv_hdr);
+            recycle(r, bid);
+        }
+        if (!live) return;
+        if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS)) c->eof = true;
+        if (!(cqe->flags & IORING_CQE_F_MORE)) c->armed = false; // re-armed by the next select
+    } else if (tag == TAG_SEND) {
+        jw_uring_batch_t *b = (jw_uring_batch_t*)(uintptr_t)(cqe->user_data & ~(uint64_t)7);
+        jw_uring_conn_t *c = &r->conns[b->conn];
+        if (c->fd >= 0 && c->gen == b->gen) c->tx_busy = false; // failures show up as a disconnect
+        free_msgs(b->msgs);
+        free(b);
+    } else if (tag == TAG_POLL) {
+        jw_uring_watch_t *w = &r->watches[cqe->user_data >> 3];
+        w->armed = false;
+        if (cqe->res > 0) w->fired = true;
+    } else if (tag == TAG_TIMER) {
+        uint32_t seq = (uint32_t)(cqe->user_data >> 3);
+        for (int i = 0; i < MAX_TIMERS; i++) {
+            if (r->timers[i].used && r->timers[i].seq == seq) r->timers[i].used = false;
+        }
+    }
+}
+
+static void reap(jw_uring_t *r) {
+    unsigned head = *r->cq_head;
+    for (;;) {
+        unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail) break;
+        while (head != tail) {
+            struct io_uring_cqe cqe = r->cqes[head & *r->cq_mask];
+            head++;
+            on_cqe(r, &cqe);
+        }
+        __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    }
+}
+
+static bool conn_readable(const jw_uring_conn_t *c) {
+    if (c->eof) return true;
+    if (c->rx_len < sizeof(jw_msg_header_t)) return false;
+    uint16_t len;
+    memcpy(&len, c->rx + offsetof(jw_msg_header_t, len), sizeof(len));
+    // A bad length is handed over as is, for the core to reject
+    return len < sizeof(jw_msg_header_t) || len > JW_MSG_MAX_LEN || c->rx_len >= len;
+}
+
+// Ready fds among want into out (if given), like select() reports them
+static int collect(jw_uring_t *r, const fd_set *want, fd_set *out) {
+    int ready = 0;
+    for (int i = 0; i < r->watch_count; i++) {
+        jw_uring_watch_t *w = &r->watches[i];
+        if (!w->fired || !FD_ISSET(w->fd, want)) continue;
+        ready++;
+        if (out) {
+            FD_SET(w->fd, out);
+            w->fired = false;
+        }
+    }
+    for (int i = 0; i < MAX_CONNS; i++) {
+        const jw_uring_conn_t *c = &r->conns[i];
+        if (c->fd < 0 || !FD_ISSET(c->fd, want) || !conn_readable(c)) continue;
+        ready++;
+        if (out) FD_SET(c->fd, out);
+    }
+    return ready;
+}
+
+int jw_uring_select(jw_uring_t *r, fd_set *readfds, uint64_t timeout_ns) {
+    fd_set want = *readfds;
+    FD_ZERO(readfds);
+
+    for (int i = 0; i < MAX_CONNS; i++) {
+        jw_uring_conn_t *c = &r->conns[i];
+        if (c->fd < 0) continue;
+        if (!c->armed && !c->eof) arm_recv(r, i);
+        flush(r, i);
+    }
+    for (int i = 0; i < r->watch_count; i++) {
+        if (!r->watches[i].armed && !r->watches[i].fired) arm_poll(r, i);
+    }
+
+    // Submissions and the wait share one syscall
+    bool wait = collect(r, &want, NULL) == 0 && timeout_ns > 0 && arm_timer(r, mono_ns() + timeout_ns);
+    if (submit(r, wait ? 1 : 0) < 0 && errno != EINTR && errno != EBUSY) return -1;
+    reap(r);
+    return collect(r, &want, readfds);
+}
+
+ssize_t jw_uring_recv(jw_uring_t *r, int fd, void *buf, size_t cap, int *passed_fd) {
+    jw_uring_conn_t *c = find_conn(r, fd);
+    if (!c) return -1;
+    if (c->rx_len >= sizeof(jw_msg_header_t)) {
+        uint16_t hdr_len;
+        memcpy(&hdr_len, c->rx + offsetof(jw_msg_header_t, len), sizeof(hdr_len));
+        size_t len = hdr_len;
+        if (len < sizeof(jw_msg_header_t) || len > cap) {
+            len = c->rx_len < cap ? c->rx_len : cap;
+        } else if (c->rx_len < len) {
+            return c->eof ? 0 : -1;
+        }
+
+        memcpy(buf, c->rx, len);
+        int kept = 0;
+        for (int i = 0; i < c->fd_count; i++) {
+            if (c->fds[i].pos < c->rx_pos + len) {
+                if (passed_fd && *passed_fd < 0) *passed_fd = c->fds[i].fd;
+                else close(c->fds[i].fd);
+            } else {
+                c->fds[kept++] = c->fds[i];
+            }
+        }
+        c->fd_count = kept;
+        memmove(c->rx, c->rx + len, c->rx_len - len);
+        c->rx_len -= len;
+        c->rx_pos += len;
+        return (ssize_t)len;
+    }
+    return c->eof ? 0 : -1;
+}
+
+size_t jw_uring_buffered(jw_uring_t *r, int fd) {
+    jw_uring_conn_t *c = find_conn(r, fd);
+    return c ? c->rx_len : 0;
+}
+
+int jw_uring_send(jw_uring_t *r, int fd, const void *buf, size_t len, int pass_fd) {
+    jw_uring_conn_t *c = find_conn(r, fd);
+    if (!c || c->eof) return -1;
+    jw_uring_msg_t *m = (jw_uring_msg_t*)malloc(sizeof(jw_uring_msg_t) + len);
+    if (!m) return -1;
+    m->next = NULL;
+    m->len = len;
+    m->pass_fd = pass_fd >= 0 ? dup(pass_fd) : -1; // may be closed before the send completes
+    memcpy(m->data, buf, len);
+    if (c->tx_tail) c->tx_tail->next = m;
+    else c->tx_head = m;
+    c->tx_tail = m;
+    return 0;
+}
+
+int jw_uring_watch(jw_uring_t *r, int fd) {
+    if (r->watch_count == MAX_WATCHES) return -1;
+    jw_uring_watch_t *w = &r->watches[r->watch_count];
+    w->fd = fd;
+    w->armed = false;
+    w->fired = false;
+    arm_poll(r, r->watch_count++);
+    return 0;
+}
+
+int jw_uring_add_client(jw_uring_t *r, int fd) {
+    for (int i = 0; i < MAX_CONNS; i++) {
+        jw_uring_conn_t *c = &r->conns[i];
+        if (c->fd >= 0) continue;
+        uint32_t gen = c->gen + 1;
+        memset(c, 0, sizeof(*c));
+        c->fd = fd;
+        c->gen = gen & 0xFFFFFF;
+        arm_recv(r, i);
+        return 0;
+    }
+    return -1;
+}
+
+void jw_uring_remove_client(jw_uring_t *r, int fd) {
+    jw_uring_conn_t *c = find_conn(r, fd);
+    if (!c) return;
+    if (c->armed) {
+        struct io_uring_sqe *sqe = get_sqe(r);
+        if (sqe) {
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = conn_tag((int)(c - r->conns), c->gen);
+            sqe->user_data = TAG_NONE;
+        }
+    }
+    for (int i = 0; i < c->fd_count; i++) close(c->fds[i].fd);
+    free_msgs(c->tx_head); // the batch in flight frees itself
+    free(c->rx);
+    uint32_t gen = c->gen;
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+    c->gen = gen; // bumped on reuse, completions still on their way are stale
+}
+
+void jw_uring_destroy(jw_uring_t *r) {
+    if (!r) return;
+    for (int i = 0; i < MAX_CONNS; i++) {
+        if (r->conns[i].fd >= 0) jw_uring_remove_client(r, r->conns[i].fd);
+    }
+    if (r->fd >= 0) close(r->fd); // in-flight batches go with the process
+    if (r->ring_ptr && r->ring_ptr != MAP_FAILED) munmap(r->ring_ptr, r->ring_size);
+    if (r->sqes && r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_size);
+    if (r->br && r->br != MAP_FAILED) munmap(r->br, r->br_size);
+    free(r->bufs);
+    free(r);
+}
+
+// A byte through a socketpair: multishot recvmsg and provided buffers work
+static bool self_test(jw_uring_t *r) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return false;
+    bool ok = jw_uring_add_client(r, sv[0]) == 0 && write(sv[1], "j", 1) == 1 && submit(r, 1) >= 0;
+    reap(r);
+    jw_uring_conn_t *c = find_conn(r, sv[0]);
+    ok = ok && c && c->rx_len == 1 && !c->eof;
+    jw_uring_remove_client(r, sv[0]);
+    submit(r, 0);
+    close(sv[0]);
+    close(sv[1]);
+    return ok;
+}
+
+jw_uring_t *jw_uring_create(void) {
+    jw_uring_t *r = (jw_uring_t*)calloc(1, sizeof(jw_uring_t));
+    if (!r) return NULL;
+    for (int i = 0; i < MAX_CONNS; i++) r->conns[i].fd = -1;
+
+    struct io_uring_params p = {0};
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = CQ_ENTRIES;
+    r->fd = (int)syscall(__NR_io_uring_setup, SQ_ENTRIES, &p);
+    if (r->fd < 0 || !(p.features & IORING_FEAT_SINGLE_MMAP)) goto fail;
+
+    size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    r->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    r->ring_ptr = mmap(NULL, r->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe*)mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->ring_ptr == MAP_FAILED || r->sqes == MAP_FAILED) goto fail;
+
+    uint8_t *ring = (uint8_t*)r->ring_ptr;
+    r->sq_head = (unsigned*)(ring + p.sq_off.head);
+    r->sq_tail = (unsigned*)(ring + p.sq_off.tail);
+    r->sq_mask = (unsigned*)(ring + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*)(ring + p.sq_off.array);
+    r->sq_entries = p.sq_entries;
+    r->sq_local = *r->sq_tail;
+    r->cq_head = (unsigned*)(ring + p.cq_off.head);
+    r->cq_tail = (unsigned*)(ring + p.cq_off.tail);
+    r->cq_mask = (unsigned*)(ring + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(ring + p.cq_off.cqes);
+
+    // Receive buffers the kernel picks from, handed back as soon as copied out
+    r->br_size = BUF_COUNT * sizeof(struct io_uring_buf);
+    r->br = (struct io_uring_buf_ring*)mmap(NULL, r->br_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    r->bufs = (uint8_t*)malloc((size_t)BUF_COUNT * BUF_SIZE);
+    if (r->br == MAP_FAILED || !r->bufs) goto fail;
+    struct io_uring_buf_reg reg = {0};
+    reg.ring_addr = (uintptr_t)r->br;
+    reg.ring_entries = BUF_COUNT;
+    reg.bgid = BUF_GROUP;
+    if (syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) goto fail;
+    for (unsigned i = 0; i < BUF_COUNT; i++) recycle(r, i);
+    r->recv_hdr.msg_controllen = CMSG_SPACE(sizeof(int) * 4);
+
+    if (!self_test(r)) goto fail;
+    return r;
+
+fail:
+    fprintf(stderr, "io_uring unavailable (%s)\n", strerror(errno));
+    jw_uring_destroy(r);
+    return NULL;
+}
+
+#else // no io_uring: the core stays on select()
+
+jw_uring_t *jw_uring_create(void) { return NULL; }
+void jw_uring_destroy(jw_uring_t *ring) { (void)ring; }
+int jw_uring_watch(jw_uring_t *ring, int fd) { (void)ring; (void)fd; return -1; }
+int jw_uring_add_client(jw_uring_t *ring, int fd) { (void)ring; (void)fd; return -1; }
+void jw_uring_remove_client(jw_uring_t *ring, int fd) { (void)ring; (void)fd; }
+int jw_uring_select(jw_uring_t *ring, fd_set *readfds, uint64_t timeout_ns) {
+    (void)ring; (void)readfds; (void)timeout_ns;
+    return -1;
+}
+ssize_t jw_uring_recv(jw_uring_t *ring, int fd, void *buf, size_t cap, int *passed_fd) {
+    (void)ring; (void)fd; (void)buf; (void)cap; (void)passed_fd;
+    return -1;
+}
+size_t jw_uring_buffered(jw_uring_t *ring, int fd) { (void)ring; (void)fd; return 0; }
+int jw_uring_send(jw_uring_t *ring, int fd, const void *buf, size_t len, int pass_fd) {
+    (void)ring; (void)fd; (void)buf; (void)len; (void)pass_fd;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,68 @@
+/**
+    -----------------------------------------------------------
+
+ 	Project JingWei
+ 	playground jw_uring.h    2026/10/19
+
+ 	@link    : https://github.com/shezw/jingwei
+ 	@author	 : shezw
+ 	@email	 : hello@shezw.com
+
+    -----------------------------------------------------------
+*/
+
+#ifndef JW_MT_URING_H
+#define JW_MT_URING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/select.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * io_uring event loop for jw_mt_core (--io-uring), on raw syscalls.
+ *
+ * Each client socket is read by one multishot recvmsg into a ring of provided
+ * buffers; messages and the fds passed with them are split out here. Sends are
+ * queued and leave as one sendmsg per client, in the same io_uring_enter()
+ * that waits for the next event, and frame deadlines are timeout ops.
+ * jw_uring_select() stands in for select(), so the core loop reads the same on
+ * both paths. Needs Linux 6.0 or later; jw_uring_create() returns NULL where
+ * it cannot work and the core stays on select().
+ */
+
+typedef struct jw_uring jw_uring_t;
+
+jw_uring_t *jw_uring_create(void);
+void jw_uring_destroy(jw_uring_t *ring);
+
+// Report fd (listening socket, pipe) from jw_uring_select() when readable
+int jw_uring_watch(jw_uring_t *ring, int fd);
+
+// Start and stop reading a client, remove before closing its socket
+int jw_uring_add_client(jw_uring_t *ring, int fd);
+void jw_uring_remove_client(jw_uring_t *ring, int fd);
+
+// select() on readfds: a client is readable once a whole message, or the end
+// of its stream, is buffered. Sends queued so far go out first.
+int jw_uring_select(jw_uring_t *ring, fd_set *readfds, uint64_t timeout_ns);
+
+// Next message of a client like recv_msg_fd(): its length, 0 once it is gone
+ssize_t jw_uring_recv(jw_uring_t *ring, int fd, void *buf, size_t cap, int *passed_fd);
+
+// Received from the client and not handed out yet
+size_t jw_uring_buffered(jw_uring_t *ring, int fd);
+
+// Queue a message like send_msg_fd(), pass_fd (if not -1) is duplicated
+int jw_uring_send(jw_uring_t *ring, int fd, const void *buf, size_t len, int pass_fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JW_MT_URING_H
@@ -10,6 +10,7 @@
 #include <time.h>
 #include <stdbool.h>
 #include "protocol.h"
+#include "shm_helper.h"
 
 // #define JW_MT_SOCKET_PATH "/tmp/jw_mt_core.sock"
 
@@ -31,24 +32,28 @@ int main() {
     uint8_t req_buf[256];
     jw_msg_header_t *hdr = (jw_msg_header_t*)req_buf;
     
-    // 1. Create Display
-    printf("Sending Create Display...\n");
+    // 1. Display and canvas in one round trip
+    printf("Sending Create Surface...\n");
     hdr->type = JW_MSG_TYPE_CMD;
-    hdr->cmd = JW_CMD_CREATE_DISPLAY;
+    hdr->cmd = JW_CMD_CREATE_SURFACE;
     hdr->msg_id = 1;
-    hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_create_display_t);
+    hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_create_surface_t);
     
-    jw_payload_create_display_t *p_disp = (jw_payload_create_display_t*)(req_buf + sizeof(jw_msg_header_t));
-    strcpy(p_disp->name, "Client1");
-    p_disp->w = 800;
-    p_disp->h = 480;
+    jw_payload_create_surface_t *p_surf = (jw_payload_create_surface_t*)(req_buf + sizeof(jw_msg_header_t));
+    memset(p_surf, 0, sizeof(*p_surf));
+    strcpy(p_surf->name, "Client1");
+    p_surf->w = 800;
+    p_surf->h = 480;
+    p_surf->format = JW_PIXFMT_XRGB8888; // same as the canvas, so it can be scanned out
+    p_surf->canvas_format = JW_PIXFMT_XRGB8888;
     
     req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
     send(sock, req_buf, hdr->len, 0);
     
-    // Wait for response
-    rlen = recv(sock, buffer, 1024, 0);
-    if (rlen < sizeof(jw_msg_header_t)) { fprintf(stderr, "Invalid response len\n"); exit(1); }
+    // Wait for response, the canvas fd comes with it
+    int shm_fd = -1;
+    rlen = recv_msg_fd(sock, buffer, 1024, &shm_fd);
+    if (rlen < (int)(sizeof(jw_msg_header_t) + sizeof(jw_payload_response_t))) { fprintf(stderr, "Invalid response len\n"); exit(1); }
     
     if (!jw_validate_checksum((uint8_t*)buffer, rlen)) { fprintf(stderr, "Invalid response Checksum\n"); exit(1); }
 
@@ -56,39 +61,10 @@ int main() {
     if (resp_hdr->type != JW_MSG_TYPE_RESP) { fprintf(stderr, "Not a response type\n"); exit(1); }
     
     jw_payload_response_t *resp_data = (jw_payload_response_t*)(buffer + sizeof(jw_msg_header_t));
-    if (resp_data->status != 0) { fprintf(stderr, "Create Display Failed\n"); exit(1); }
+    if (resp_data->status != 0 || shm_fd < 0) { fprintf(stderr, "Create Surface Failed\n"); exit(1); }
     
     int display_id = resp_data->data.new_id;
     printf("Client 1: Display created, ID: %d\n", display_id);
-
-    // 2. Create Canvas
-    printf("Sending Create Canvas...\n");
-    hdr->cmd = JW_CMD_CREATE_CANVAS;
-    hdr->msg_id = 2;
-    hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_create_canvas_t);
-    
-    jw_payload_create_canvas_t *p_cvs = (jw_payload_create_canvas_t*)(req_buf + sizeof(jw_msg_header_t));
-    p_cvs->display_id = display_id;
-    p_cvs->w = 800;
-    p_cvs->h = 480;
-    
-    req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
-    send(sock, req_buf, hdr->len, 0);
-    
-    rlen = recv(sock, buffer, 1024, 0);
-    if (rlen < sizeof(jw_msg_header_t)) { fprintf(stderr, "Invalid response len\n"); exit(1); }
-    resp_hdr = (jw_msg_header_t*)buffer; 
-    resp_data = (jw_payload_response_t*)(buffer + sizeof(jw_msg_header_t));
-    
-    // Note: status 0 is OK.
-    if (resp_data->status != 0) { fprintf(stderr, "Create Canvas Failed: %s\n", resp_data->data.message); exit(1); }
-    
-    char shm_name[64];
-    strncpy(shm_name, resp_data->data.message, 63);
-    printf("Shared Memory: %s\n", shm_name);
-
-    int shm_fd = shm_open(shm_name, O_RDWR, 0666);
-    if (shm_fd == -1) { perror("shm_open"); exit(1); }
     
     uint32_t *canvas = mmap(0, 800 * 480 * 4, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
     if (canvas == MAP_FAILED) { perror("mmap"); exit(1); }
@@ -112,6 +88,8 @@ int main() {
         
         jw_payload_commit_t *p_commit = (jw_payload_commit_t*)(req_buf + sizeof(jw_msg_header_t));
         p_commit->display_id = display_id;
+        p_commit->input_serial = 0;
+        memset(&p_commit->damage, 0, sizeof(p_commit->damage)); // not tracked, the core finds out
         
         req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
         send(sock, req_buf, hdr->len, 0);
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -10,6 +11,10 @@
 #include <time.h>
 #include <stdbool.h>
 #include "protocol.h"
+#include "shm_helper.h"
+
+#define ICON_SIZE 64
+#define CARD_COUNT 3
 
 int main() {
     int sock = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -40,6 +45,7 @@ int main() {
     strcpy(p_disp->name, "Client2");
     p_disp->w = 640;
     p_disp->h = 480;
+    p_disp->format = JW_PIXFMT_RGB565; // low bandwidth panel
     
     req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
     send(sock, req_buf, hdr->len, 0);
@@ -59,58 +65,181 @@ int main() {
     int display_id = resp_data->data.new_id;
     printf("Client 2: Display created, ID: %d\n", display_id);
 
-    // 2. Create Canvas
-    printf("Sending Create Canvas...\n");
-    hdr->cmd = JW_CMD_CREATE_CANVAS;
+    // 2. Background: a gradient layer, no pixel buffer behind it
+    hdr->cmd = JW_CMD_CREATE_LAYER;
     hdr->msg_id = 2;
-    hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_create_canvas_t);
-    
-    jw_payload_create_canvas_t *p_cvs = (jw_payload_create_canvas_t*)(req_buf + sizeof(jw_msg_header_t));
-    p_cvs->display_id = display_id;
-    p_cvs->w = 640;
-    p_cvs->h = 480;
-    
+    hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_create_layer_t);
+
+    jw_payload_create_layer_t *p_layer = (jw_payload_create_layer_t*)(req_buf + sizeof(jw_msg_header_t));
+    memset(p_layer, 0, sizeof(*p_layer));
+    p_layer->display_id = display_id;
+    p_layer->desc.w = 640;
+    p_layer->desc.h = 480;
+    p_layer->desc.opacity = 255;
+    p_layer->desc.visible = 1;
+    p_layer->desc.content = JW_LAYER_CONTENT_GRADIENT;
+    p_layer->desc.flags = JW_LAYER_F_VERTICAL;
+    p_layer->desc.u.color.from = 0xFF103060;
+    p_layer->desc.u.color.to = 0xFF60A0E0;
+
     req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
     send(sock, req_buf, hdr->len, 0);
-    
+
     rlen = recv(sock, buffer, 1024, 0);
     if (rlen < sizeof(jw_msg_header_t)) { fprintf(stderr, "Invalid response len\n"); exit(1); }
-    resp_hdr = (jw_msg_header_t*)buffer; 
     resp_data = (jw_payload_response_t*)(buffer + sizeof(jw_msg_header_t));
-    
-    // Note: status 0 is OK.
-    if (resp_data->status != 0) { fprintf(stderr, "Create Canvas Failed: %s\n", resp_data->data.message); exit(1); }
-    
-    char shm_name[64];
-    strncpy(shm_name, resp_data->data.message, 63);
-    printf("Shared Memory: %s\n", shm_name);
+    if (resp_data->status != 0) { fprintf(stderr, "Create Layer Failed\n"); exit(1); }
+    printf("Client 2: Background layer %d\n", resp_data->data.new_id);
 
-    int shm_fd = shm_open(shm_name, O_RDWR, 0666);
-    if (shm_fd == -1) { perror("shm_open"); exit(1); }
-    
-    uint32_t *canvas = mmap(0, 640 * 480 * 4, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
-    if (canvas == MAP_FAILED) { perror("mmap"); exit(1); }
+    // 3. Upload an icon mask once, the core keeps it resident and tints it
+    int icon_fd = shm_create_anon("icon", ICON_SIZE * ICON_SIZE);
+    if (icon_fd == -1) { perror("shm_create_anon"); exit(1); }
+    uint8_t *icon = mmap(0, ICON_SIZE * ICON_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, icon_fd, 0);
+    if (icon == MAP_FAILED) { perror("mmap"); exit(1); }
+    for (int y = 0; y < ICON_SIZE; y++) {
+        for (int x = 0; x < ICON_SIZE; x++) {
+            int dx = x - ICON_SIZE / 2, dy = y - ICON_SIZE / 2;
+            bool inside = dx * dx + dy * dy < (ICON_SIZE / 2) * (ICON_SIZE / 2);
+            icon[y * ICON_SIZE + x] = inside ? 0xFF : 0x00; // disc
+        }
+    }
+    munmap(icon, ICON_SIZE * ICON_SIZE);
+    if (shm_seal(icon_fd, false) == -1) { perror("shm_seal"); exit(1); }
+
+    hdr->cmd = JW_CMD_UPLOAD_RESOURCE;
+    hdr->msg_id = 3;
+    hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_upload_resource_t);
+
+    jw_payload_upload_resource_t *p_res = (jw_payload_upload_resource_t*)(req_buf + sizeof(jw_msg_header_t));
+    p_res->w = ICON_SIZE;
+    p_res->h = ICON_SIZE;
+    p_res->stride = ICON_SIZE;
+    p_res->format = JW_PIXFMT_A8;
+
+    req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
+    send_msg_fd(sock, req_buf, hdr->len, icon_fd);
+    close(icon_fd);
+
+    rlen = recv(sock, buffer, 1024, 0);
+    if (rlen < sizeof(jw_msg_header_t)) { fprintf(stderr, "Invalid response len\n"); exit(1); }
+    resp_data = (jw_payload_response_t*)(buffer + sizeof(jw_msg_header_t));
+    if (resp_data->status != 0) { fprintf(stderr, "Upload Resource Failed\n"); exit(1); }
+
+    uint32_t icon_id = resp_data->data.new_id;
+    printf("Client 2: Icon uploaded, resource %u\n", icon_id);
+
+    // 4. A few cards, animated together through transactions
+    uint32_t card_ids[CARD_COUNT];
+    const uint32_t card_colors[CARD_COUNT] = { 0xFFE05050, 0xFF50E050, 0xFF5050E0 };
+    for (int i = 0; i < CARD_COUNT; i++) {
+        hdr->cmd = JW_CMD_CREATE_LAYER;
+        hdr->msg_id++;
+        hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_create_layer_t);
+
+        memset(p_layer, 0, sizeof(*p_layer));
+        p_layer->display_id = display_id;
+        p_layer->desc.w = 96;
+        p_layer->desc.h = 64;
+        p_layer->desc.opacity = 200;
+        p_layer->desc.visible = 1;
+        p_layer->desc.content = JW_LAYER_CONTENT_SOLID;
+        p_layer->desc.u.color.from = card_colors[i];
 
-    // Render Loop
-    printf("Starting render loop...\n");
+        req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
+        send(sock, req_buf, hdr->len, 0);
+
+        rlen = recv(sock, buffer, 1024, 0);
+        if (rlen < sizeof(jw_msg_header_t)) { fprintf(stderr, "Invalid response len\n"); exit(1); }
+        resp_data = (jw_payload_response_t*)(buffer + sizeof(jw_msg_header_t));
+        if (resp_data->status != 0) { fprintf(stderr, "Create Layer Failed\n"); exit(1); }
+        card_ids[i] = resp_data->data.new_id;
+    }
+
+    // 5. Render Loop, no canvas: the core rasterises our draw list
+    printf("Starting render loop (draw list)...\n");
     int r = 0, g = 0, b = 0;
+    int frame = 0;
     while(1) {
-        for(int i=0; i < 640*480; i++) {
-            canvas[i] = (255 << 24) | (r << 16) | (g << 8) | b;
+        // Move every card in one message, shown by the draw list commit below
+        hdr->cmd = JW_CMD_TRANSACTION;
+        hdr->msg_id++;
+
+        jw_payload_transaction_t *p_txn = (jw_payload_transaction_t*)(req_buf + sizeof(jw_msg_header_t));
+        p_txn->display_id = display_id;
+        p_txn->flags = 0;
+        p_txn->count = CARD_COUNT;
+
+        jw_txn_record_t *recs = (jw_txn_record_t*)(req_buf + sizeof(jw_msg_header_t) + sizeof(jw_payload_transaction_t));
+        memset(recs, 0, CARD_COUNT * sizeof(jw_txn_record_t));
+        for (int i = 0; i < CARD_COUNT; i++) {
+            recs[i].layer_id = card_ids[i];
+            recs[i].mask = JW_LAYER_SET_GEOMETRY | JW_LAYER_SET_OPACITY;
+            recs[i].desc.x = 100 + i * 160;
+            recs[i].desc.y = 20 + (frame * (i + 1) * 2) % 360;
+            recs[i].desc.w = 96;
+            recs[i].desc.h = 64;
+            recs[i].desc.opacity = 128 + (frame * 3) % 128;
+        }
+        // Every second, bring the bottom card to the top
+        if (frame % 30 == 0) {
+            recs[0].mask |= JW_LAYER_SET_ORDER;
+            recs[0].above = card_ids[CARD_COUNT - 1];
+            uint32_t first = card_ids[0];
+            memmove(card_ids, card_ids + 1, (CARD_COUNT - 1) * sizeof(uint32_t));
+            card_ids[CARD_COUNT - 1] = first;
         }
 
+        hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_transaction_t) + CARD_COUNT * sizeof(jw_txn_record_t);
+        req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
+        send(sock, req_buf, hdr->len, 0);
+        rlen = recv(sock, buffer, 1024, 0);
+
+        hdr->cmd = JW_CMD_DRAW;
+        hdr->msg_id++;
+
+        jw_payload_draw_t *p_draw = (jw_payload_draw_t*)(req_buf + sizeof(jw_msg_header_t));
+        p_draw->display_id = display_id;
+        p_draw->flags = JW_DRAW_LIST_COMMIT;
+        p_draw->count = 3;
+
+        jw_draw_op_t *ops = (jw_draw_op_t*)(req_buf + sizeof(jw_msg_header_t) + sizeof(jw_payload_draw_t));
+        memset(ops, 0, 3 * sizeof(jw_draw_op_t));
+
+        // Translucent panel over the background layer
+        ops[0].op = JW_DRAW_BLEND_RECT;
+        ops[0].alpha = 160;
+        ops[0].x = 80;
+        ops[0].y = 80;
+        ops[0].w = 480;
+        ops[0].h = 320;
+        ops[0].u.color.from = (255 << 24) | (r << 16) | (g << 8) | b;
+
+        // Status bar
+        ops[1].op = JW_DRAW_GRADIENT;
+        ops[1].alpha = 255;
+        ops[1].y = 440;
+        ops[1].w = 640;
+        ops[1].h = 40;
+        ops[1].u.color.from = 0xFF202020;
+        ops[1].u.color.to = 0xFF808080;
+
+        // Bouncing icon
+        ops[2].op = JW_DRAW_MASK;
+        ops[2].alpha = 255;
+        ops[2].x = (frame * 4) % (640 - ICON_SIZE);
+        ops[2].y = 200;
+        ops[2].w = ICON_SIZE;
+        ops[2].h = ICON_SIZE;
+        ops[2].u.mask.resource_id = icon_id;
+        ops[2].u.mask.color = 0xFFFFD700; // gold
+        frame++;
+
+        hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_draw_t) + 3 * sizeof(jw_draw_op_t);
+
         r = (r + 8) % 255;
         g = (g + 4) % 255;
         b = (b + 2) % 255;
 
-        // Commit (Binary)
-        hdr->cmd = JW_CMD_COMMIT;
-        hdr->msg_id++;
-        hdr->len = sizeof(jw_msg_header_t) + sizeof(jw_payload_commit_t);
-        
-        jw_payload_commit_t *p_commit = (jw_payload_commit_t*)(req_buf + sizeof(jw_msg_header_t));
-        p_commit->display_id = display_id;
-        
         req_buf[6] = jw_calculate_checksum(req_buf, hdr->len);
         send(sock, req_buf, hdr->len, 0);
         
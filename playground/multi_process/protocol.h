@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
+#include "jw_crc32c.h"
 
 #define JW_MT_SOCKET_PATH "/tmp/jw_mt_core.sock"
 
@@ -14,14 +15,41 @@ enum {
     JW_MSG_TYPE_EVT = 0x03
 };
 
+// Largest message on the socket, bigger commands go through JW_CMD_BULK
+#define JW_MSG_MAX_LEN 8192
+
 // Message Command
 enum {
     JW_CMD_CREATE_DISPLAY = 0x10,
     JW_CMD_CREATE_CANVAS  = 0x11,
     JW_CMD_COMMIT         = 0x12,
+    JW_CMD_DRAW           = 0x13,
+    JW_CMD_UPLOAD_RESOURCE = 0x14,
+    JW_CMD_FREE_RESOURCE  = 0x15,
+    JW_CMD_CREATE_LAYER   = 0x16,
+    JW_CMD_UPDATE_LAYER   = 0x17,
+    JW_CMD_DESTROY_LAYER  = 0x18,
+    JW_CMD_TRANSACTION    = 0x19,
+    JW_CMD_STATS          = 0x1A,
+    JW_CMD_INPUT          = 0x1B,
+    JW_CMD_SET_PRIORITY   = 0x1C,
+    JW_CMD_CREATE_SURFACE = 0x1D,
+    JW_CMD_BULK_ATTACH    = 0x1E,
+    JW_CMD_BULK           = 0x1F,
+    JW_CMD_CAPTURE        = 0x20,
+    JW_CMD_SET_INTEGRITY  = 0x21,
     JW_CMD_RESPONSE       = 0xFF
 };
 
+// Pixel formats
+enum {
+    JW_PIXFMT_ARGB8888 = 0x00,
+    JW_PIXFMT_XRGB8888 = 0x01, // opaque, alpha byte ignored
+    JW_PIXFMT_RGB565   = 0x02,
+    JW_PIXFMT_ARGB4444 = 0x03,
+    JW_PIXFMT_A8       = 0x04  // resources only: masks / glyphs, tinted when drawn
+};
+
 // Protocol Header
 // Total 7 bytes: TYPE(1) CMD(1) LEN(2) ID(2) CS(1)
 typedef struct __attribute__((packed)) {
@@ -39,18 +67,372 @@ typedef struct __attribute__((packed)) {
     char name[32];
     uint16_t w;
     uint16_t h;
+    uint8_t format;     // JW_PIXFMT_*, what the output scans out
 } jw_payload_create_display_t;
 
+// w/h may be below the display size (0 = display size), the core scales it up
+// The response carries the shm name in data.message and the canvas fd (SCM_RIGHTS).
+// A full-size canvas in the display format that is the only thing showing is
+// scanned out without composition.
 typedef struct __attribute__((packed)) {
     int display_id;
     uint16_t w;
     uint16_t h;
+    uint8_t format;     // JW_PIXFMT_*, need not match the display
 } jw_payload_create_canvas_t;
 
+// Display and canvas in one round trip (JW_CMD_CREATE_SURFACE)
+// The response carries the display id in data.new_id and the canvas fd.
+typedef struct __attribute__((packed)) {
+    char name[32];
+    uint16_t w;
+    uint16_t h;
+    uint8_t format;         // display, as in jw_payload_create_display_t
+    uint16_t canvas_w;      // as in jw_payload_create_canvas_t
+    uint16_t canvas_h;
+    uint8_t canvas_format;
+    uint16_t refresh_hz;    // optional, 0 = the output's own rate
+} jw_payload_create_surface_t;
+
+// Clients built before input_serial or damage existed send less, that still works.
+// Without damage the core takes the whole canvas as changed, or with
+// `jw_mt_core --auto-damage` compares it tile by tile with the last commit.
 typedef struct __attribute__((packed)) {
     int display_id;
+    uint32_t input_serial; // newest jw_event_t.serial this frame reacts to, 0 = none
+    struct __attribute__((packed)) {
+        int16_t x, y;
+        uint16_t w, h;     // w 0 = not given
+    } damage;              // canvas pixels that changed
 } jw_payload_commit_t;
 
+// Draw list (JW_CMD_DRAW)
+// The list is retained per display and rasterised by the core at composition,
+// so a client that paints with a few rects never touches a full canvas.
+enum {
+    JW_DRAW_FILL_RECT  = 0x01, // color.from
+    JW_DRAW_BLIT       = 0x02, // blit.resource_id from JW_CMD_UPLOAD_RESOURCE, 0 = the display's own canvas
+    JW_DRAW_GRADIENT   = 0x03, // color.from -> color.to, JW_DRAW_F_VERTICAL
+    JW_DRAW_BLEND_RECT = 0x04, // color.from blended with alpha
+    JW_DRAW_MASK       = 0x05  // A8 resource mask.resource_id tinted with mask.color
+};
+
+// Draw op flags
+#define JW_DRAW_F_VERTICAL  0x0001
+
+typedef struct __attribute__((packed)) {
+    uint8_t op;
+    uint8_t alpha;      // global alpha, 255 = opaque
+    uint16_t flags;
+    int16_t x, y;
+    uint16_t w, h;
+    union {
+        struct __attribute__((packed)) {
+            uint32_t from;  // ARGB8888
+            uint32_t to;
+        } color;
+        struct __attribute__((packed)) {
+            uint32_t resource_id;
+            int16_t sx, sy; // source origin
+        } blit;
+        struct __attribute__((packed)) {
+            uint32_t resource_id;
+            int16_t sx, sy;
+            uint32_t color;
+        } mask;
+    } u;
+} jw_draw_op_t;
+
+_Static_assert(sizeof(jw_draw_op_t) == 24, "Draw op size must be 24 bytes");
+
+// Draw list flags
+#define JW_DRAW_LIST_APPEND 0x01 // append to the retained list instead of replacing it
+#define JW_DRAW_LIST_COMMIT 0x02 // present right away, saves the JW_CMD_COMMIT round trip
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint8_t flags;
+    uint16_t count;     // long lists go through JW_CMD_BULK
+    // jw_draw_op_t ops[count] follows
+} jw_payload_draw_t;
+
+// Resources (JW_CMD_UPLOAD_RESOURCE)
+// The pixels live in a shm/memfd passed with the message (SCM_RIGHTS).
+// The core keeps its own copy resident and answers with the handle in new_id.
+// It may drop the copy and read the memory again later, so on systems with
+// memfd seals the fd must carry F_SEAL_SHRINK and F_SEAL_WRITE (shm_seal()).
+typedef struct __attribute__((packed)) {
+    uint16_t w;
+    uint16_t h;
+    uint32_t stride;    // bytes per row in the passed memory
+    uint8_t format;     // JW_PIXFMT_*, kept as is (A8 stays 1 byte per pixel)
+} jw_payload_upload_resource_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t resource_id;
+} jw_payload_free_resource_t;
+
+// Layers
+// Layers are composed bottom-up in creation order, the draw list goes on top.
+// Canvas and resource content is stretched to the layer rect when sizes differ.
+// Solid and gradient layers have no pixel buffer at all: the core renders them
+// from their parameters during composition. Changes show at the next commit.
+enum {
+    JW_LAYER_CONTENT_CANVAS   = 0x00, // the display canvas (JW_CMD_CREATE_CANVAS)
+    JW_LAYER_CONTENT_SOLID    = 0x01, // u.color.from
+    JW_LAYER_CONTENT_GRADIENT = 0x02, // u.color.from -> u.color.to, JW_LAYER_F_VERTICAL
+    JW_LAYER_CONTENT_RESOURCE = 0x03  // u.resource.id, A8 resources are tinted with u.resource.tint
+};
+
+// Layer flags
+#define JW_LAYER_F_VERTICAL 0x01 // gradient direction
+#define JW_LAYER_F_NEAREST  0x02 // nearest instead of bilinear when the content is scaled
+#define JW_LAYER_F_OPAQUE   0x04 // client promises every pixel of the layer rect is opaque
+
+typedef struct __attribute__((packed)) {
+    int16_t x, y;
+    uint16_t w, h;
+    uint8_t opacity;
+    uint8_t visible;
+    uint8_t content;
+    uint8_t flags;
+    union {
+        struct __attribute__((packed)) {
+            uint32_t from;  // ARGB8888
+            uint32_t to;
+        } color;
+        struct __attribute__((packed)) {
+            uint32_t id;
+            uint32_t tint;
+        } resource;
+    } u;
+} jw_layer_desc_t;
+
+_Static_assert(sizeof(jw_layer_desc_t) == 20, "Layer desc size must be 20 bytes");
+
+// JW_CMD_UPDATE_LAYER mask
+#define JW_LAYER_SET_GEOMETRY 0x01
+#define JW_LAYER_SET_OPACITY  0x02
+#define JW_LAYER_SET_VISIBLE  0x04
+#define JW_LAYER_SET_CONTENT  0x08
+#define JW_LAYER_SET_ORDER    0x10 // JW_CMD_TRANSACTION only, see jw_txn_record_t
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    jw_layer_desc_t desc;
+} jw_payload_create_layer_t;
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint32_t layer_id;
+    uint32_t mask;      // JW_LAYER_SET_*, fields outside the mask are ignored
+    jw_layer_desc_t desc;
+} jw_payload_update_layer_t;
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint32_t layer_id;
+} jw_payload_destroy_layer_t;
+
+// Layer transactions (JW_CMD_TRANSACTION)
+// Any number of layer changes in one message with one reply. Either all records
+// apply or none do (the reply's new_id is then the index of the bad record), and
+// no frame ever shows part of a transaction.
+typedef struct __attribute__((packed)) {
+    uint32_t layer_id;
+    uint32_t mask;      // JW_LAYER_SET_*
+    uint32_t above;     // JW_LAYER_SET_ORDER: restack right above this layer, 0 = bottom
+    jw_layer_desc_t desc;
+} jw_txn_record_t;
+
+_Static_assert(sizeof(jw_txn_record_t) == 32, "Transaction record size must be 32 bytes");
+
+#define JW_TXN_PRESENT 0x01 // present right away instead of at the next commit
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint8_t flags;      // JW_TXN_*
+    uint16_t count;     // followed by count * jw_txn_record_t, long ones go through JW_CMD_BULK
+} jw_payload_transaction_t;
+
+// Input (JW_CMD_INPUT)
+// A client sends JW_INPUT_F_LISTEN to get the input of a display, or
+// JW_INPUT_F_INJECT to feed `event` in as if it came from the device (reply
+// new_id = the serial given to it). The listener receives each event as a
+// JW_MSG_TYPE_EVT message with cmd JW_CMD_INPUT and flags 0, and names the
+// newest event a frame reacts to in jw_payload_commit_t.input_serial: that
+// is what input-to-photon latency is measured against.
+enum {
+    JW_INPUT_POINTER_DOWN   = 0x01,
+    JW_INPUT_POINTER_MOTION = 0x02,
+    JW_INPUT_POINTER_UP     = 0x03
+};
+
+typedef struct __attribute__((packed)) {
+    uint32_t serial;        // assigned by the core, increasing
+    uint8_t type;           // JW_INPUT_*
+    uint8_t button;
+    int16_t x, y;
+    uint64_t timestamp;     // CLOCK_MONOTONIC ns the input happened, 0 on inject = now
+} jw_event_t;
+
+#define JW_INPUT_F_LISTEN 0x01
+#define JW_INPUT_F_INJECT 0x02
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint8_t flags;          // JW_INPUT_F_*
+    jw_event_t event;
+} jw_payload_input_t;
+
+// Scheduling (JW_CMD_SET_PRIORITY)
+// Each frame the core serves interactive clients first, then normal, then
+// background ones, and within a class the client whose display is due for
+// vsync soonest. Normal and background clients get a bounded amount of core
+// time per frame; past it they wait for the next frame. Interactive is meant
+// for cursors and video, it is never throttled. Clients start as normal.
+enum {
+    JW_PRIO_BACKGROUND  = 0x00,
+    JW_PRIO_NORMAL      = 0x01,
+    JW_PRIO_INTERACTIVE = 0x02,
+    JW_PRIO_COUNT
+};
+
+typedef struct __attribute__((packed)) {
+    uint8_t priority;       // JW_PRIO_*
+} jw_payload_set_priority_t;
+
+// Runtime stats (JW_CMD_STATS)
+// The reply is a jw_payload_response_t followed by jw_stats_reply_t, then
+// client_count jw_stats_client_t and output_count jw_stats_output_t.
+// interval_ms > 0 also sends the asking client the same report every
+// interval_ms as a JW_MSG_TYPE_EVT message with cmd JW_CMD_STATS (and no
+// jw_payload_response_t), 0 stops it. Latencies are in microseconds.
+typedef struct __attribute__((packed)) {
+    uint32_t interval_ms;
+} jw_payload_stats_t;
+
+typedef struct __attribute__((packed)) {
+    uint64_t uptime_ms;
+    uint8_t client_count;
+    uint8_t output_count;
+    uint64_t huge_bytes;    // pixel memory on huge pages now (MAP_HUGETLB, THP per smaps), jw_mt_core --alloc
+    uint64_t locked_bytes;  // pixel memory mlocked now
+    uint32_t alloc_fallbacks; // --alloc asked for more than the system gave
+} jw_stats_reply_t;
+
+#define JW_STATS_F_SELF 0x01 // the client that asked
+
+typedef struct __attribute__((packed)) {
+    uint8_t slot;           // connection slot in the core
+    uint8_t flags;          // JW_STATS_F_*
+    uint16_t commit_rate;   // frames committed in the last full second
+    uint32_t commits;       // COMMIT, DRAW and TRANSACTION messages that present
+    uint64_t bytes_uploaded;// resource uploads
+    uint64_t shm_bytes;     // client memory the core holds: canvases, resources
+    uint32_t queued_bytes;  // sent but not yet read by the core
+    uint32_t latency_us[4]; // request handling p50, p90, p99, max
+    uint8_t priority;       // JW_PRIO_*
+    uint32_t throttled;     // frames in which the client used up its budget
+} jw_stats_client_t;
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint32_t frames;
+    uint32_t missed_vsyncs; // frames whose composite + present overran the refresh period
+    uint16_t refresh_hz;
+    uint16_t dirty_permille;// recomposed share of the screen over all frames
+    uint32_t composite_us[4];
+    uint32_t present_us[4]; // texture upload and present
+    uint32_t commit_to_present_us[4];  // frame message received to presented
+    uint32_t input_to_photon_us[4];    // jw_event_t.timestamp to the frame reacting to it
+    uint32_t tile_hash_us[4];          // finding the damage of a commit, jw_mt_core --auto-damage
+    uint16_t w, h;          // as created, before --rotate
+} jw_stats_output_t;
+
+// Bulk channel (JW_CMD_BULK_ATTACH, JW_CMD_BULK)
+// Commands larger than JW_MSG_MAX_LEN travel through a shared memory region
+// the client attaches once per connection: BULK_ATTACH passes its fd
+// (SCM_RIGHTS) and size, the core maps it read-only and drops any earlier one.
+// Where there are memfd seals the fd must carry F_SEAL_SHRINK (shm_seal()
+// with writable set). The core copies each command out before looking at it.
+// BULK then names a range in it holding a whole command message, header
+// first. Only type and cmd of the inner header are used, the reply carries the
+// BULK message's msg_id and an fd passed with BULK belongs to the inner
+// command. The range must be left alone until the reply.
+#define JW_BULK_MAX_SIZE (64u << 20)
+
+typedef struct __attribute__((packed)) {
+    uint32_t size;
+} jw_payload_bulk_attach_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t offset;
+    uint32_t length;        // inner header included
+} jw_payload_bulk_t;
+
+// Screen capture (JW_CMD_CAPTURE)
+// The composited output of a display (what it shows, before --rotate) is
+// written into memory the client passes with the request (SCM_RIGHTS), area
+// x,y,w,h of the display (which it must lie within, see jw_stats_output_t for
+// the size) at the buffer's origin, converted to `format`. Where the system
+// has memfd seals the memory must carry F_SEAL_SHRINK, see shm_seal().
+// Without JW_CAPTURE_F_STREAM the reply comes once the area is written (new_id
+// = the frame's seq) and the core lets go of the memory.
+//
+// A stream is answered right away. Each frame that changes the area is then
+// announced by a JW_MSG_TYPE_EVT message with cmd JW_CMD_CAPTURE carrying
+// jw_capture_frame_t; only the rects it lists were rewritten. The client owns
+// the buffer until it sends JW_CAPTURE_F_RELEASE (no fd). Until then nothing
+// is written or sent: changes add up and come with the next frame, so a slow
+// consumer gets fewer, larger updates and never holds up the display. One
+// capture per display at a time.
+#define JW_CAPTURE_F_STREAM  0x01 // keep sending changes
+#define JW_CAPTURE_F_RELEASE 0x02 // done reading the last frame
+#define JW_CAPTURE_F_STOP    0x04 // end the stream
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint8_t flags;          // JW_CAPTURE_F_*
+    uint8_t format;         // JW_PIXFMT_*, not A8
+    int16_t x, y;
+    uint16_t w, h;          // w 0 = the whole display
+    uint32_t stride;        // bytes per row in the passed memory, 0 = w * bytes per pixel
+} jw_payload_capture_t;
+
+typedef struct __attribute__((packed)) {
+    int16_t x, y;           // buffer coordinates, the area's origin is 0,0
+    uint16_t w, h;
+} jw_capture_rect_t;
+
+typedef struct __attribute__((packed)) {
+    int display_id;
+    uint32_t seq;           // frames written so far
+    uint64_t timestamp;     // CLOCK_MONOTONIC ns the frame was presented
+    uint8_t count;          // followed by count jw_capture_rect_t
+} jw_capture_frame_t;
+
+// Message integrity (JW_CMD_SET_INTEGRITY)
+// Connections start on the header checksum byte, jw_calculate_checksum(),
+// which only looks at the header and one payload byte. JW_INTEGRITY_CRC32C
+// covers the whole message instead: the checksum byte is 0 and a CRC32C of
+// everything before it follows the payload (JW_CRC_LEN bytes, little endian,
+// counted in len). The request and its reply use the mode in force before it,
+// every message after them, both ways, the new one. The reply's new_id is
+// the mode; a core that doesn't know the command answers with status -1
+// (older ones not at all, so don't wait forever). See jw_msg_seal() and
+// jw_msg_open().
+enum {
+    JW_INTEGRITY_CHECKSUM = 0x00,
+    JW_INTEGRITY_CRC32C   = 0x01
+};
+
+#define JW_CRC_LEN 4
+
+typedef struct __attribute__((packed)) {
+    uint8_t mode;           // JW_INTEGRITY_*
+} jw_payload_set_integrity_t;
+
 // Response payload
 typedef struct __attribute__((packed)) {
     int status; // 0 OK, <0 Error
@@ -100,4 +482,37 @@ static inline bool jw_validate_checksum(const uint8_t *msg, size_t len) {
     return calculated == msg[6];
 }
 
+// Finish a message of len bytes (header len already set to len) for sending
+// in `mode`. The CRC needs JW_CRC_LEN more bytes of room after it. Returns
+// the length to send.
+static inline size_t jw_msg_seal(uint8_t *msg, size_t len, uint8_t mode) {
+    if (mode != JW_INTEGRITY_CRC32C) {
+        msg[6] = jw_calculate_checksum(msg, len);
+        return len;
+    }
+    uint16_t total = (uint16_t)(len + JW_CRC_LEN);
+    memcpy(msg + 2, &total, sizeof(total));
+    msg[6] = 0;
+    uint32_t crc = jw_crc32c(0, msg, len);
+    memcpy(msg + len, &crc, sizeof(crc));
+    return total;
+}
+
+// Check a received message of len bytes in `mode` and drop its CRC, header
+// len included. Returns the length left, 0 if it is corrupt.
+static inline size_t jw_msg_open(uint8_t *msg, size_t len, uint8_t mode) {
+    if (mode != JW_INTEGRITY_CRC32C) return jw_validate_checksum(msg, len) ? len : 0;
+    if (len < sizeof(jw_msg_header_t) + JW_CRC_LEN || msg[6] != 0) return 0;
+    uint16_t total;
+    memcpy(&total, msg + 2, sizeof(total));
+    if (total != len) return 0;
+    uint32_t crc;
+    len -= JW_CRC_LEN;
+    memcpy(&crc, msg + len, sizeof(crc));
+    if (crc != jw_crc32c(0, msg, len)) return 0;
+    uint16_t body = (uint16_t)len;
+    memcpy(msg + 2, &body, sizeof(body));
+    return len;
+}
+
 #endif // JW_MT_PROTOCOL_H
@@ -7,9 +7,13 @@
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
 
 // Helper to send file descriptor
-static int send_fd(int socket, int fd) {
+static inline int send_fd(int socket, int fd) {
     struct msghdr msg = {0};
     struct cmsghdr *cmsg;
     char buf[CMSG_SPACE(sizeof(int))];
@@ -37,7 +41,7 @@ static int send_fd(int socket, int fd) {
 }
 
 // Helper to receive file descriptor
-static int recv_fd(int socket, int *fd) {
+static inline int recv_fd(int socket, int *fd) {
     struct msghdr msg = {0};
     struct cmsghdr *cmsg;
     char buf[CMSG_SPACE(sizeof(int))];
@@ -66,4 +70,85 @@ static int recv_fd(int socket, int *fd) {
     }
 }
 
+// Send a whole message with an optional fd attached (fd == -1: none)
+static inline ssize_t send_msg_fd(int socket, const void *data, size_t len, int fd) {
+    struct msghdr msg = {0};
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct iovec io = { .iov_base = (void*)data, .iov_len = len };
+
+    msg.msg_iov = &io;
+    msg.msg_iovlen = 1;
+
+    if (fd != -1) {
+        memset(buf, 0, sizeof(buf));
+        msg.msg_control = buf;
+        msg.msg_controllen = sizeof(buf);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    return sendmsg(socket, &msg, 0);
+}
+
+// Receive message bytes and the fd passed with them, *fd is -1 if none
+static inline ssize_t recv_msg_fd(int socket, void *data, size_t len, int *fd) {
+    struct msghdr msg = {0};
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct iovec io = { .iov_base = data, .iov_len = len };
+
+    msg.msg_iov = &io;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+
+    *fd = -1;
+    ssize_t n = recvmsg(socket, &msg, 0);
+    if (n <= 0) return n;
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+        memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    return n;
+}
+
+// Anonymous shareable memory: memfd where available, unlinked POSIX shm otherwise
+static inline int shm_create_anon(const char *tag, size_t size) {
+    int fd = -1;
+#if defined(__linux__) && defined(MFD_CLOEXEC) && defined(MFD_ALLOW_SEALING)
+    fd = memfd_create(tag, MFD_CLOEXEC | MFD_ALLOW_SEALING); // see shm_seal()
+#elif defined(__linux__) && defined(MFD_CLOEXEC)
+    fd = memfd_create(tag, MFD_CLOEXEC);
+#endif
+    if (fd == -1) {
+        char name[64];
+        snprintf(name, sizeof(name), "/jw_%s_%d_%ld", tag, (int)getpid(), (long)clock());
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd == -1) return -1;
+        shm_unlink(name);
+    }
+    if (ftruncate(fd, size) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Freeze fd for the core: no resizing, and no writes unless `writable` (then
+// only the size is fixed, as for capture memory). Writable shared mappings
+// must be gone before writes can be sealed. A no-op where there are no seals.
+static inline int shm_seal(int fd, bool writable) {
+#if defined(F_ADD_SEALS)
+    return fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL | (writable ? 0 : F_SEAL_WRITE));
+#else
+    (void)fd;
+    (void)writable;
+    return 0;
+#endif
+}
+
 #endif